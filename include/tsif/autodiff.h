@@ -0,0 +1,215 @@
+#ifndef TSIF_AUTODIFF_H_
+#define TSIF_AUTODIFF_H_
+
+#include "tsif/element_vector.h"
+#include "tsif/utils/common.h"
+
+#include <unsupported/Eigen/AutoDiff>
+
+namespace Eigen {
+
+// Found by argument dependent lookup from Eigen::numext, e.g. in the SVD fallback of Quaternion::FromTwoVectors
+template <typename DerType>
+bool isfinite(const AutoDiffScalar<DerType>& x) {
+  return std::isfinite(x.value());
+}
+
+}  // namespace Eigen
+
+namespace tsif {
+
+/*! \brief Dual Number.
+ *         Forward-mode automatic differentiation scalar carrying N directional derivatives.
+ */
+template <int N, typename S = double>
+using Dual = Eigen::AutoDiffScalar<Vec<N, S>>;
+
+template <int N, typename S>
+class ElementTraits<Eigen::AutoDiffScalar<Vec<N, S>>> : public ScalarElementTraits<Eigen::AutoDiffScalar<Vec<N, S>>> {};
+
+/*! \brief Scalar Rebind Trait.
+ *         Type of an element value T with its scalar type replaced by S.
+ */
+template <typename T, typename S>
+struct ScalarRebindTrait {
+  typedef S Type;
+};
+template <int N, typename T, typename S>
+struct ScalarRebindTrait<Vec<N, T>, S> {
+  typedef Vec<N, S> Type;
+};
+template <typename T, typename S>
+struct ScalarRebindTrait<QuatT<T>, S> {
+  typedef QuatT<S> Type;
+};
+template <typename T, typename S>
+struct ScalarRebindTrait<UnitVectorT<T>, S> {
+  typedef UnitVectorT<S> Type;
+};
+template <typename T, size_t N, typename S>
+struct ScalarRebindTrait<std::array<T, N>, S> {
+  typedef std::array<typename ScalarRebindTrait<T, S>::Type, N> Type;
+};
+template <typename T, size_t N, typename S>
+struct ScalarRebindTrait<BoundedArray<T, N>, S> {
+  typedef BoundedArray<typename ScalarRebindTrait<T, S>::Type, N> Type;
+};
+template <typename E, typename S>
+using ElementRebind = Element<typename ScalarRebindTrait<typename E::Type, S>::Type, E::kI>;
+
+/*! \brief Converts an element value to the corresponding value with a different scalar type.
+ */
+template <typename T, typename S>
+void CastElement(const T& in, S& out) {
+  out = S(in);
+}
+template <int N, typename T, typename S>
+void CastElement(const Vec<N, T>& in, Vec<N, S>& out) {
+  out = in.template cast<S>();
+}
+template <typename T, typename S>
+void CastElement(const QuatT<T>& in, QuatT<S>& out) {
+  out = in.template cast<S>();
+}
+template <typename T, typename S>
+void CastElement(const UnitVectorT<T>& in, UnitVectorT<S>& out) {
+  out.SetQuat(in.GetQuat().template cast<S>());
+}
+template <typename T, typename S, size_t N>
+void CastElement(const std::array<T, N>& in, std::array<S, N>& out) {
+  for (size_t i = 0; i < N; i++) {
+    CastElement(in[i], out[i]);
+  }
+}
+template <typename T, typename S, size_t N>
+void CastElement(const BoundedArray<T, N>& in, BoundedArray<S, N>& out) {
+  for (size_t i = 0; i < N; i++) {
+    CastElement(in[i], out[i]);
+    out.SetActive(i, in.IsActive(i));
+  }
+}
+template <typename In, typename Out, size_t... Cs>
+void CastElementVector(const In& in, Out& out, std::index_sequence<Cs...>) {
+  (CastElement(in.template Get<In::kIds[Cs]>(), out.template Get<Out::kIds[Cs]>()), ...);
+}
+template <typename In, typename Out>
+void CastElementVector(const In& in, Out& out) {
+  static_assert(In::kN == Out::kN, "Element vectors do not match");
+  CastElementVector(in, out, std::make_index_sequence<In::kN>{});
+}
+
+template <typename R, typename = void>
+struct HasRebindTrait : std::false_type {};
+template <typename R>
+struct HasRebindTrait<R, std::void_t<typename R::template Rebind<double>>> : std::true_type {};
+
+/*! \brief Marks the construction of rebound residuals on this thread (see RebindCache). Their parameters are taken over
+ *         with CopyParameters, such that they skip the random default measurement of ResidualBase and leave the random
+ *         number streams untouched.
+ */
+class RebindConstruction {
+ public:
+  RebindConstruction() : wasActive_(IsActive()) { IsActive() = true; }
+  ~RebindConstruction() { IsActive() = wasActive_; }
+  static bool& IsActive() {
+    thread_local bool isActive = false;
+    return isActive;
+  }
+
+ private:
+  const bool wasActive_;
+};
+
+/*! \brief Rebound residuals of a residual used by its automatic differentiation, one per input N (see JacAutoDiff).
+ *         They are built once and refreshed with CopyParameters on every Jacobian. Copies of the owning residual start
+ *         without them, such that residuals never share them (e.g. across the threads of cloned filters).
+ */
+class RebindCache {
+ public:
+  RebindCache() = default;
+  RebindCache(const RebindCache& /*other*/) {}
+  RebindCache& operator=(const RebindCache& /*other*/) { return *this; }
+  template <int N, typename RT>
+  RT& Get() {
+    if (!res_[N]) {
+      RebindConstruction construction;
+      res_[N] = std::make_shared<RT>();
+    }
+    return *static_cast<RT*>(res_[N].get());
+  }
+
+ private:
+  std::array<std::shared_ptr<void>, 2> res_;
+};
+
+/*! \brief Seeds element C of a cast input with Boxplus of a dual perturbation, whose derivatives start at the compact
+ *         start of the element.
+ */
+template <int C, typename T, typename InT>
+void SeedAutoDiffElement(InT& inT) {
+  constexpr int I = InT::kIds[C];
+  constexpr int D = InT::kDims[C];
+  if constexpr (D > 0) {
+    auto& element = inT.template Get<I>();
+    typedef typename std::decay<decltype(element)>::type ElementType;
+    const ElementType element0 = element;
+    Vec<D, T> dif;
+    for (int j = 0; j < D; j++) {
+      dif(j) = T(0, InT::Dim(), InT::Start(I) + j);
+    }
+    ElementTraits<ElementType>::Boxplus(element0, dif, element);
+  }
+}
+template <typename T, typename InT, size_t... Cs>
+void SeedAutoDiff(InT& inT, std::index_sequence<Cs...>) {
+  (SeedAutoDiffElement<Cs, T>(inT), ...);
+}
+template <int N, int C, typename R, typename Y>
+void WriteAutoDiffElement(const Y& y, MatRef<-1, -1, typename R::Scalar> J, const typename R::Previous::CRef pre,
+                          const typename R::Current::CRef cur) {
+  typedef typename std::tuple_element<N, std::tuple<typename R::Previous, typename R::Current>>::type In;
+  constexpr int I = In::kIds[C];
+  constexpr int D = In::kDims[C];
+  if constexpr (D > 0) {
+    const int start = std::get<N>(std::forward_as_tuple(pre, cur)).Start(I);
+    for (int r = 0; r < y.size(); r++) {
+      J.template block<1, D>(r, start) = y(r).derivatives().template segment<D>(In::Start(I)).transpose();
+    }
+  }
+}
+template <int N, typename R, typename Y, size_t... Cs>
+void WriteAutoDiff(const Y& y, MatRef<-1, -1, typename R::Scalar> J, const typename R::Previous::CRef pre,
+                   const typename R::Current::CRef cur, std::index_sequence<Cs...>) {
+  (WriteAutoDiffElement<N, Cs, R>(y, J, pre, cur), ...);
+}
+
+/*! \brief Jacobian of a residual with respect to its input N (0: previous, 1: current) by forward-mode automatic
+ *         differentiation. The residual is evaluated once as R::Rebind<Dual<D>>, D being the dimension of the input,
+ *         with every element seeded by Boxplus of a dual perturbation at its compact start. The rebound residual is
+ *         kept in cache and takes over the parameters of res through CopyParameters (see ResidualBase).
+ */
+template <int N, typename R>
+void JacAutoDiff(R& res, RebindCache& cache, MatRef<-1, -1, typename R::Scalar> J, const typename R::Previous::CRef pre,
+                 const typename R::Current::CRef cur) {
+  typedef typename std::tuple_element<N, std::tuple<typename R::Previous, typename R::Current>>::type In;
+  if constexpr (In::Dim() > 0) {
+    typedef Dual<In::Dim(), typename R::Scalar> T;
+    typedef typename R::template Rebind<T> RT;
+    RT& resT = cache.template Get<N, RT>();
+    resT.CopyParameters(res);
+    typename RT::Previous preT;
+    typename RT::Current curT;
+    CastElementVector(pre, preT);
+    CastElementVector(cur, curT);
+    SeedAutoDiff<T>(std::get<N>(std::tie(preT, curT)), std::make_index_sequence<In::kN>{});
+    typename RT::Output outT;
+    resT.EvalRes(outT, preT, curT);
+    Vec<RT::Output::Dim(), T> y;
+    outT.GetVec(y);
+    WriteAutoDiff<N, R>(y, J, pre, cur, std::make_index_sequence<In::kN>{});
+  }
+}
+
+}  // namespace tsif
+
+#endif  // TSIF_AUTODIFF_H_
@@ -0,0 +1,175 @@
+#ifndef TSIF_BATCH_FILTER_H_
+#define TSIF_BATCH_FILTER_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tsif/filter.h"
+#include "tsif/utils/batch_dense.h"
+
+namespace tsif {
+
+/*! \brief Batch Filter
+ *         K instances of the same filter type (e.g. Monte Carlo runs or initialization hypotheses) which are updated in
+ *         lockstep. Measurements are added to the instances with the usual residual API (GetFilter(l).AddMeas). The
+ *         residuals of every instance are evaluated as usual, the dense solve of all instances is gathered into
+ *         BatchMatrix (structure-of-arrays) form and vectorized across the instances. Instances with a reduced problem
+ *         (inactive BoundedArray slots) or a failing factorization are solved individually. Instances whose update
+ *         times differ are updated independently.
+ */
+template <typename FilterType>
+class BatchFilter {
+ public:
+  typedef typename FilterType::State State;
+  typedef typename FilterType::Scalar Scalar;
+  typedef typename FilterType::StagedStep StagedStep;
+
+  explicit BatchFilter(int lanes) : filters_(lanes) {}
+
+  int GetNumLanes() const { return filters_.size(); }
+  FilterType& GetFilter(int l) { return filters_[l]; }
+  const FilterType& GetFilter(int l) const { return filters_[l]; }
+
+  void Update() {
+    std::vector<std::set<TimePoint>> times(filters_.size());
+    bool isLockstep = true;
+    for (size_t l = 0; l < filters_.size(); l++) {
+      filters_[l].PrepareUpdate(times[l]);
+      isLockstep = isLockstep && times[l] == times[0];
+    }
+    if (isLockstep) {
+      for (const auto& t : times[0]) {
+        MakeUpdateStep(t);
+      }
+    } else {
+      for (size_t l = 0; l < filters_.size(); l++) {
+        filters_[l].RunUpdateSteps(times[l]);
+      }
+    }
+    for (auto& filter : filters_) {
+      filter.Clean(filter.GetTime());
+    }
+  }
+
+  /*! \brief Update step of all instances at t. The instances iterate in lockstep until each has converged.
+   */
+  void MakeUpdateStep(TimePoint t) {
+    for (auto& filter : filters_) {
+      StagedStep staged;
+      filter.PrepareStep(t, filter.GetTime(), staged);
+      filter.BeginUpdateStep(staged);
+    }
+    std::vector<int> lanes;
+    while (true) {
+      lanes.clear();
+      for (size_t l = 0; l < filters_.size(); l++) {
+        if (filters_[l].IsIterating()) {
+          lanes.push_back(l);
+        }
+      }
+      if (lanes.empty()) {
+        break;
+      }
+      for (int l : lanes) {
+        filters_[l].AssembleIteration();
+      }
+      SolveIteration(lanes);
+      for (int l : lanes) {
+        filters_[l].ApplyIteration();
+      }
+    }
+    for (auto& filter : filters_) {
+      filter.FinishUpdateStep(t);
+    }
+  }
+
+ private:
+  /*! \brief Solves the current iteration of the given instances. Full problems are batched in chunks of kChunkLanes
+   *         instances (such that the batch matrices stay in cache), the others are solved individually.
+   */
+  void SolveIteration(const std::vector<int>& lanes) {
+    std::vector<int> batch;
+    for (int l : lanes) {
+      if (filters_[l].IsReduced()) {
+        filters_[l].SolveIteration();
+      } else {
+        batch.push_back(l);
+      }
+    }
+    for (size_t begin = 0; begin < batch.size(); begin += kChunkLanes) {
+      const std::vector<int> chunk(batch.begin() + begin, batch.begin() + std::min(begin + kChunkLanes, batch.size()));
+      if (chunk.size() == 1) {
+        filters_[chunk[0]].SolveIteration();
+      } else {
+        SolveBatch(chunk);
+      }
+    }
+  }
+
+  /*! \brief Batched version of Filter::ComputeUpdateParallel (Cholesky factorizations of D and of the new information)
+   *         for the given instances, writes updateInf_ and updateDx_ of each instance.
+   */
+  void SolveBatch(const std::vector<int>& batch) {
+    const int n = State::Dim();
+    const int K = batch.size();
+    L_.Resize(n, n, K);
+    Y_.Resize(n, n, K);
+    z_.Resize(n, 1, K);
+    inf_.Resize(n, n, K);
+    grad_.Resize(n, 1, K);
+    for (int b = 0; b < K; b++) {
+      const FilterType& filter = filters_[batch[b]];
+      L_.SetLane(b, filter.I_ + filter.Hpp_);
+      Y_.SetLane(b, filter.Hpc_);
+      z_.SetLane(b, filter.bp_);
+      inf_.SetLane(b, filter.Hcc_);
+      grad_.SetLane(b, filter.bc_);
+    }
+    BatchLLT(L_, isFactorized_);
+    BatchLowerSolve(L_, Y_);
+    BatchLowerSolve(L_, z_);
+    BatchSubtractTransposeProduct(Y_, Y_, inf_);
+    BatchSubtractTransposeProduct(Y_, z_, grad_);
+    for (int j = 0; j < n; j++) {
+      for (int i = j + 1; i < n; i++) {
+        Scalar* lower = inf_(i, j);
+        Scalar* upper = inf_(j, i);
+        for (int b = 0; b < K; b++) {
+          lower[b] = Scalar(0.5) * (lower[b] + upper[b]);
+          upper[b] = lower[b];
+        }
+      }
+    }
+    Linf_ = inf_;
+    BatchLLT(Linf_, isInfFactorized_);
+    BatchLowerSolve(Linf_, grad_);
+    BatchLowerTransposeSolve(Linf_, grad_);
+    for (int b = 0; b < K; b++) {
+      FilterType& filter = filters_[batch[b]];
+      if (isFactorized_[b] && isInfFactorized_[b]) {
+        filter.updateInf_.resize(n, n);
+        inf_.GetLane(b, filter.updateInf_);
+        filter.updateDx_.resize(n);
+        grad_.GetLane(b, filter.updateDx_);
+        filter.updateDx_ = -filter.updateDx_;
+      } else {
+        filter.SolveIteration();
+      }
+    }
+  }
+
+  static constexpr size_t kChunkLanes = 16;
+  std::vector<FilterType> filters_;
+  BatchMatrix<Scalar> L_;     // Cholesky factor of D = I + Hpp
+  BatchMatrix<Scalar> Y_;     // L^-1 * Hpc
+  BatchMatrix<Scalar> z_;     // L^-1 * bp
+  BatchMatrix<Scalar> inf_;   // New information Hcc - Y^T * Y
+  BatchMatrix<Scalar> Linf_;  // Cholesky factor of the new information
+  BatchMatrix<Scalar> grad_;  // bc - Y^T * z, solved in place for -dx
+  std::vector<char> isFactorized_;
+  std::vector<char> isInfFactorized_;
+};
+
+}  // namespace tsif
+
+#endif  // TSIF_BATCH_FILTER_H_
@@ -0,0 +1,100 @@
+#ifndef TSIF_BOUNDED_ARRAY_H_
+#define TSIF_BOUNDED_ARRAY_H_
+
+#include "tsif/utils/common.h"
+
+namespace tsif{
+
+/*! \brief Bounded Array.
+ *         Array of fixed capacity N where every slot can be activated and
+ *         deactivated at runtime. Inactive slots keep their value but are
+ *         excluded from the estimation (see ElementTraits<BoundedArray>).
+ */
+template<typename T, size_t N>
+class BoundedArray{
+ private:
+  std::array<T,N> x_;
+  std::array<bool,N> active_;
+  int count_;
+ public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  typedef T value_type;
+  BoundedArray(): count_(0){
+    active_.fill(false);
+  }
+  static constexpr size_t size(){
+    return N;
+  }
+  T& operator[](size_t i){
+    return x_[i];
+  }
+  const T& operator[](size_t i) const{
+    return x_[i];
+  }
+  T& at(size_t i){
+    return x_.at(i);
+  }
+  const T& at(size_t i) const{
+    return x_.at(i);
+  }
+  typename std::array<T,N>::iterator begin(){
+    return x_.begin();
+  }
+  typename std::array<T,N>::const_iterator begin() const{
+    return x_.begin();
+  }
+  typename std::array<T,N>::iterator end(){
+    return x_.end();
+  }
+  typename std::array<T,N>::const_iterator end() const{
+    return x_.end();
+  }
+  bool IsActive(size_t i) const{
+    return active_.at(i);
+  }
+  void SetActive(size_t i, bool active){
+    count_ += (int)active - (int)active_.at(i);
+    active_.at(i) = active;
+  }
+  int GetActiveCount() const{
+    return count_;
+  }
+  /*! \brief Activates the first inactive slot and returns its index (-1 if full).
+   */
+  int Activate(){
+    for(size_t i=0;i<N;i++){
+      if(!active_[i]){
+        SetActive(i,true);
+        return i;
+      }
+    }
+    return -1;
+  }
+};
+
+template<typename T, size_t N>
+bool IsSlotActive(const std::array<T,N>& /*x*/, size_t /*i*/){
+  return true;
+}
+template<typename T, size_t N>
+bool IsSlotActive(const BoundedArray<T,N>& x, size_t i){
+  return x.IsActive(i);
+}
+template<typename T, size_t N>
+void SetSlotActive(std::array<T,N>& /*x*/, size_t /*i*/, bool /*active*/){}
+template<typename T, size_t N>
+void SetSlotActive(BoundedArray<T,N>& x, size_t i, bool active){
+  x.SetActive(i,active);
+}
+template<typename T, size_t N>
+void CopySlotActivity(const std::array<T,N>& /*in*/, std::array<T,N>& /*out*/){}
+template<typename T, size_t N>
+void CopySlotActivity(const BoundedArray<T,N>& in, BoundedArray<T,N>& out){
+  for(size_t i=0;i<N;i++){
+    out.SetActive(i,in.IsActive(i));
+  }
+}
+
+} // namespace tsif
+
+#endif  // TSIF_BOUNDED_ARRAY_H_
@@ -1,6 +1,7 @@
 #ifndef TSIF_ELEMENT_H_
 #define TSIF_ELEMENT_H_
 
+#include "tsif/bounded_array.h"
 #include "tsif/utils/common.h"
 #include "unit_vector.h"
 
@@ -8,6 +9,7 @@ namespace tsif {
 
 template <typename T>
 struct ElementTraits {
+  typedef double Scalar;
   static constexpr int kDim = 0;
   static std::string Print(const T& x) { return ""; }
   static T Identity() {
@@ -25,6 +27,7 @@ struct ElementTraits {
   static Mat<kDim, kDim> BoxminusJacRef(const T& in, const T& ref) { return Mat<kDim, kDim>::Identity(); }
   static Vec<kDim> GetVec(const T& x) { return Vec<kDim>::Zero(); }
   static void Scale(double w, T& x) {}
+  static bool IsActive(const T& x, int j) { return true; }
 };
 
 template <typename T, int I>
@@ -36,6 +39,7 @@ class Element {
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   typedef T Type;
+  typedef typename Traits::Scalar Scalar;
   static const int kI = I;
   static const int kDim = Traits::kDim * (int)(I >= 0);
 
@@ -52,60 +56,61 @@ class Element {
   void SetIdentity() { x_ = Traits::Identity(); }
   void SetRandom() { Traits::SetRandom(x_); }
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  void Boxplus(const VecCRef<kDim>& vec, Element<T, I>& out) const {
+  void Boxplus(const VecCRef<kDim, Scalar>& vec, Element<T, I>& out) const {
     Traits::Boxplus(x_, vec, out.Get());
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  void Boxplus(const VecCRef<kDim>& /*vec*/, Element<T, I>& out) const {
+  void Boxplus(const VecCRef<kDim, Scalar>& /*vec*/, Element<T, I>& out) const {
     out.Get() = x_;
   }
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  void Boxminus(const Element<T, I>& ref, VecRef<kDim> vec) const {
+  void Boxminus(const Element<T, I>& ref, VecRef<kDim, Scalar> vec) const {
     Traits::Boxminus(x_, ref.Get(), vec);
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  void Boxminus(const Element<T, I>& /*ref*/, VecRef<kDim> /*vec*/) const {}
+  void Boxminus(const Element<T, I>& /*ref*/, VecRef<kDim, Scalar> /*vec*/) const {}
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  Mat<kDim> BoxplusJacInp(const VecCRef<kDim>& vec) const {
+  Mat<kDim, kDim, Scalar> BoxplusJacInp(const VecCRef<kDim, Scalar>& vec) const {
     return Traits::BoxplusJacInp(x_, vec);
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  Mat<kDim> BoxplusJacInp(const VecCRef<kDim>& vec) const {
-    return Mat<kDim>::Zero();
+  Mat<kDim, kDim, Scalar> BoxplusJacInp(const VecCRef<kDim, Scalar>& vec) const {
+    return Mat<kDim, kDim, Scalar>::Zero();
   }
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  Mat<kDim> BoxplusJacVec(const VecCRef<kDim>& vec) const {
+  Mat<kDim, kDim, Scalar> BoxplusJacVec(const VecCRef<kDim, Scalar>& vec) const {
     return Traits::BoxplusJacVec(x_, vec);
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  Mat<kDim> BoxplusJacVec(const VecCRef<kDim>& vec) const {
-    return Mat<kDim>::Zero();
+  Mat<kDim, kDim, Scalar> BoxplusJacVec(const VecCRef<kDim, Scalar>& vec) const {
+    return Mat<kDim, kDim, Scalar>::Zero();
   }
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  Mat<kDim> BoxminusJacInp(const Element<T, I>& ref) const {
+  Mat<kDim, kDim, Scalar> BoxminusJacInp(const Element<T, I>& ref) const {
     return Traits::BoxminusJacInp(x_, ref.Get());
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  Mat<kDim> BoxminusJacInp(const Element<T, I>& /*ref*/) const {
-    return Mat<kDim>::Zero();
+  Mat<kDim, kDim, Scalar> BoxminusJacInp(const Element<T, I>& /*ref*/) const {
+    return Mat<kDim, kDim, Scalar>::Zero();
   }
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  Mat<kDim> BoxminusJacRef(const Element<T, I>& ref) const {
+  Mat<kDim, kDim, Scalar> BoxminusJacRef(const Element<T, I>& ref) const {
     return Traits::BoxminusJacRef(x_, ref.Get());
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  Mat<kDim> BoxminusJacRef(const Element<T, I>& /*ref*/) const {
-    return Mat<kDim>::Zero();
+  Mat<kDim, kDim, Scalar> BoxminusJacRef(const Element<T, I>& /*ref*/) const {
+    return Mat<kDim, kDim, Scalar>::Zero();
   }
   template <bool B = I >= 0, typename std::enable_if<B>::type* = nullptr>
-  Vec<kDim> GetVec() const {
+  Vec<kDim, Scalar> GetVec() const {
     return Traits::GetVec(x_);
   }
   template <bool B = I >= 0, typename std::enable_if<!B>::type* = nullptr>
-  Vec<kDim> GetVec() const {
-    return Vec<kDim>::Zero();
+  Vec<kDim, Scalar> GetVec() const {
+    return Vec<kDim, Scalar>::Zero();
   }
   void Scale(double w) { Traits::Scale(w, x_); }
+  bool IsActive(int j) const { return kDim > 0 && Traits::IsActive(x_, j); }
 };
 
 template <typename T, int I>
@@ -113,152 +118,166 @@ const int Element<T, I>::kI;
 
 // ==================== Traits Implementation ==================== //
 /*! \brief Scalar Trait.
- *         Element trait for regular scalar.
+ *         Element trait for regular scalar of type S.
  */
-template <>
-class ElementTraits<double> {
+template <typename S>
+class ScalarElementTraits {
  public:
+  typedef S Scalar;
   static constexpr int kDim = 1;
-  static std::string Print(const double& x) {
+  static std::string Print(const S& x) {
     std::ostringstream out;
     out << x;
     return out.str();
   }
-  static double Identity() { return 0; }
-  static void SetRandom(double& x) { x = NormalRandomNumberGenerator::Instance().Get(); }
-  static void Boxplus(const double& in, const VecCRef<kDim>& vec, double& out) { out = in + vec(0); }
-  static void Boxminus(const double& in, const double& ref, VecRef<kDim> vec) { vec(0) = in - ref; }
-  static Mat<kDim> BoxplusJacInp(const double& /*in*/, const VecCRef<kDim>& /*vec*/) { return Mat<kDim>::Identity(); }
-  static Mat<kDim> BoxplusJacVec(const double& /*in*/, const VecCRef<kDim>& /*vec*/) { return Mat<kDim>::Identity(); }
-  static Mat<kDim> BoxminusJacInp(const double& /*in*/, const double& /*ref*/) { return Mat<kDim>::Identity(); }
-  static Mat<kDim> BoxminusJacRef(const double& /*in*/, const double& /*ref*/) { return -Mat<kDim>::Identity(); }
-  static Vec<kDim> GetVec(const double& x) { return Vec<1>(x); }
-  static void Scale(double w, double& x) { x *= w; }
+  static S Identity() { return S(0); }
+  static void SetRandom(S& x) { x = NormalRandomNumberGenerator::Instance().Get(); }
+  static void Boxplus(const S& in, const VecCRef<kDim, S>& vec, S& out) { out = in + vec(0); }
+  static void Boxminus(const S& in, const S& ref, VecRef<kDim, S> vec) { vec(0) = in - ref; }
+  static Mat<kDim, kDim, S> BoxplusJacInp(const S& /*in*/, const VecCRef<kDim, S>& /*vec*/) { return Mat<kDim, kDim, S>::Identity(); }
+  static Mat<kDim, kDim, S> BoxplusJacVec(const S& /*in*/, const VecCRef<kDim, S>& /*vec*/) { return Mat<kDim, kDim, S>::Identity(); }
+  static Mat<kDim, kDim, S> BoxminusJacInp(const S& /*in*/, const S& /*ref*/) { return Mat<kDim, kDim, S>::Identity(); }
+  static Mat<kDim, kDim, S> BoxminusJacRef(const S& /*in*/, const S& /*ref*/) { return -Mat<kDim, kDim, S>::Identity(); }
+  static Vec<kDim, S> GetVec(const S& x) { return Vec<kDim, S>(x); }
+  static void Scale(double w, S& x) { x *= w; }
+  static bool IsActive(const S& /*x*/, int /*j*/) { return true; }
 };
+template <>
+class ElementTraits<double> : public ScalarElementTraits<double> {};
+template <>
+class ElementTraits<float> : public ScalarElementTraits<float> {};
 
 /*! \brief Vector Trait.
  *         Element trait for vector of scalars
  */
-template <int N>
-class ElementTraits<Vec<N>> {
+template <int N, typename S>
+class ElementTraits<Vec<N, S>> {
  public:
+  typedef S Scalar;
   static constexpr int kDim = N;
-  static std::string Print(const Vec<N>& x) {
+  static std::string Print(const Vec<N, S>& x) {
     std::ostringstream out;
     out << x.transpose();
     return out.str();
   }
-  static Vec<N> Identity() { return Vec<N>::Zero(); }
-  static void SetRandom(Vec<N>& x) { x = NormalRandomNumberGenerator::Instance().GetVec<N>(); }
-  static void Boxplus(const Vec<N>& in, const VecCRef<kDim>& vec, Vec<N>& out) { out = in + vec; }
-  static void Boxminus(const Vec<N>& in, const Vec<N>& ref, VecRef<kDim> vec) { vec = in - ref; }
-  static Mat<kDim> BoxplusJacInp(const Vec<N>& in, const VecCRef<kDim>& vec) { return Mat<kDim>::Identity(); }
-  static Mat<kDim> BoxplusJacVec(const Vec<N>& in, const VecCRef<kDim>& vec) { return Mat<kDim>::Identity(); }
-  static Mat<kDim> BoxminusJacInp(const Vec<N>& /*in*/, const Vec<N>& /*ref*/) { return Mat<kDim>::Identity(); }
-  static Mat<kDim> BoxminusJacRef(const Vec<N>& /*in*/, const Vec<N>& /*ref*/) { return -Mat<kDim>::Identity(); }
-  static Vec<kDim> GetVec(const Vec<N>& x) { return x; }
-  static void Scale(double w, Vec<N>& x) { x *= w; }
+  static Vec<N, S> Identity() { return Vec<N, S>::Zero(); }
+  static void SetRandom(Vec<N, S>& x) { x = NormalRandomNumberGenerator::Instance().GetVec<N>().template cast<S>(); }
+  static void Boxplus(const Vec<N, S>& in, const VecCRef<kDim, S>& vec, Vec<N, S>& out) { out = in + vec; }
+  static void Boxminus(const Vec<N, S>& in, const Vec<N, S>& ref, VecRef<kDim, S> vec) { vec = in - ref; }
+  static Mat<kDim, kDim, S> BoxplusJacInp(const Vec<N, S>& in, const VecCRef<kDim, S>& vec) { return Mat<kDim, kDim, S>::Identity(); }
+  static Mat<kDim, kDim, S> BoxplusJacVec(const Vec<N, S>& in, const VecCRef<kDim, S>& vec) { return Mat<kDim, kDim, S>::Identity(); }
+  static Mat<kDim, kDim, S> BoxminusJacInp(const Vec<N, S>& /*in*/, const Vec<N, S>& /*ref*/) { return Mat<kDim, kDim, S>::Identity(); }
+  static Mat<kDim, kDim, S> BoxminusJacRef(const Vec<N, S>& /*in*/, const Vec<N, S>& /*ref*/) { return -Mat<kDim, kDim, S>::Identity(); }
+  static Vec<kDim, S> GetVec(const Vec<N, S>& x) { return x; }
+  static void Scale(double w, Vec<N, S>& x) { x *= w; }
+  static bool IsActive(const Vec<N, S>& /*x*/, int /*j*/) { return true; }
 };
 
 /*! \brief Unit Quaternion Trait.
  *         Element trait for unit quaternion. Employed to represent
  *         orientations.
  */
-template <>
-class ElementTraits<Quat> {
+template <typename S>
+class ElementTraits<QuatT<S>> {
  public:
+  typedef S Scalar;
+  typedef QuatT<S> Q;
   static constexpr int kDim = 3;
-  static std::string Print(const Quat& x) {
+  static std::string Print(const Q& x) {
     std::ostringstream out;
     out << x.w() << " " << x.x() << " " << x.y() << " " << x.z();
     return out.str();
   }
-  static Quat Identity() { return Quat::Identity(); }
-  static void SetRandom(Quat& x) {
-    x.w() = NormalRandomNumberGenerator::Instance().Get();
-    x.x() = NormalRandomNumberGenerator::Instance().Get();
-    x.y() = NormalRandomNumberGenerator::Instance().Get();
-    x.z() = NormalRandomNumberGenerator::Instance().Get();
+  static Q Identity() { return Q::Identity(); }
+  static void SetRandom(Q& x) {
+    x.coeffs() = NormalRandomNumberGenerator::Instance().GetVec<4>().template cast<S>();
     x.normalize();
   }
-  static void Boxplus(const Quat& in, const VecCRef<kDim>& vec, Quat& out) {
+  static void Boxplus(const Q& in, const VecCRef<kDim, S>& vec, Q& out) {
     out = tsif::Boxplus(in, vec);
     out.normalize();
   }
-  static void Boxminus(const Quat& in, const Quat& ref, VecRef<kDim> vec) { vec = tsif::Boxminus(in, ref); }
-  static Mat<kDim> BoxplusJacInp(const Quat& /*in*/, const VecCRef<kDim>& vec) { return Exp(vec).toRotationMatrix(); }
-  static Mat<kDim> BoxplusJacVec(const Quat& /*in*/, const VecCRef<kDim>& vec) { return GammaMat(vec); }
-  static Mat<kDim> BoxminusJacInp(const Quat& in, const Quat& ref) { return GammaMat(tsif::Boxminus(in, ref)).inverse(); }
-  static Mat<kDim> BoxminusJacRef(const Quat& in, const Quat& ref) {
-    return -GammaMat(tsif::Boxminus(in, ref)).inverse() * (in * ref.inverse()).toRotationMatrix();
+  static void Boxminus(const Q& in, const Q& ref, VecRef<kDim, S> vec) { vec = tsif::Boxminus(in, ref); }
+  static Mat<kDim, kDim, S> BoxplusJacInp(const Q& /*in*/, const VecCRef<kDim, S>& vec) { return Exp(vec).toRotationMatrix(); }
+  static Mat<kDim, kDim, S> BoxplusJacVec(const Q& /*in*/, const VecCRef<kDim, S>& vec) { return GammaMat(vec); }
+  static Mat<kDim, kDim, S> BoxminusJacInp(const Q& in, const Q& ref) { return GammaMatInv(tsif::Boxminus(in, ref)); }
+  static Mat<kDim, kDim, S> BoxminusJacRef(const Q& in, const Q& ref) {
+    return -GammaMatInv(tsif::Boxminus(in, ref)) * (in * ref.inverse()).toRotationMatrix();
   }
-  static Vec<kDim> GetVec(const Quat& x) { return Log(x); }
-  static void Scale(double w, Quat& x) { x = Exp(w * Log(x)); }
+  static Vec<kDim, S> GetVec(const Q& x) { return Log(x); }
+  static void Scale(double w, Q& x) { x = Exp(w * Log(x)); }
+  static bool IsActive(const Q& /*x*/, int /*j*/) { return true; }
 };
 
 /*! \brief Unit Vector Trait.
  *         Element trait for unit vectors.
  */
-template <>
-class ElementTraits<UnitVector> {
+template <typename S>
+class ElementTraits<UnitVectorT<S>> {
  public:
+  typedef S Scalar;
+  typedef UnitVectorT<S> U;
   static constexpr int kDim = 2;
-  static std::string Print(const UnitVector& x) {
+  static std::string Print(const U& x) {
     std::ostringstream out;
     out << x.GetVec().transpose();
     return out.str();
   }
-  static UnitVector Identity() { return UnitVector(Quat::Identity()); }
-  static void SetRandom(UnitVector& x) { x.SetRandom(); }
-  static void Boxplus(const UnitVector& in, const VecCRef<kDim>& vec, UnitVector& out) { in.Boxplus(vec, out); }
-  static void Boxminus(const UnitVector& in, const UnitVector& ref, VecRef<kDim> vec) { in.Boxminus(ref, vec); }
-  static Mat<kDim> BoxplusJacInp(const UnitVector& in, const VecCRef<kDim>& vec) {
-    Mat<kDim> J;
+  static U Identity() { return U(QuatT<S>::Identity()); }
+  static void SetRandom(U& x) { x.SetRandom(); }
+  static void Boxplus(const U& in, const VecCRef<kDim, S>& vec, U& out) { in.Boxplus(vec, out); }
+  static void Boxminus(const U& in, const U& ref, VecRef<kDim, S> vec) { in.Boxminus(ref, vec); }
+  static Mat<kDim, kDim, S> BoxplusJacInp(const U& in, const VecCRef<kDim, S>& vec) {
+    Mat<kDim, kDim, S> J;
     in.BoxplusJacInp(vec, J);
     return J;
   }
-  static Mat<kDim> BoxplusJacVec(const UnitVector& in, const VecCRef<kDim>& vec) {
-    Mat<kDim> J;
+  static Mat<kDim, kDim, S> BoxplusJacVec(const U& in, const VecCRef<kDim, S>& vec) {
+    Mat<kDim, kDim, S> J;
     in.BoxplusJacVec(vec, J);
     return J;
   }
-  static Mat<kDim> BoxminusJacInp(const UnitVector& in, const UnitVector& ref) {
-    Mat<kDim> J;
+  static Mat<kDim, kDim, S> BoxminusJacInp(const U& in, const U& ref) {
+    Mat<kDim, kDim, S> J;
     in.BoxminusJacInp(ref, J);
     return J;
   }
-  static Mat<kDim> BoxminusJacRef(const UnitVector& in, const UnitVector& ref) {
-    Mat<kDim> J;
+  static Mat<kDim, kDim, S> BoxminusJacRef(const U& in, const U& ref) {
+    Mat<kDim, kDim, S> J;
     in.BoxminusJacRef(ref, J);
     return J;
   }
-  static Vec<kDim> GetVec(const UnitVector& x) {
-    Vec<kDim> vec;
+  static Vec<kDim, S> GetVec(const U& x) {
+    Vec<kDim, S> vec;
     x.Boxminus(Identity(), vec);
     return vec;
   }
-  static void Scale(double w, UnitVector& x) {
-    Vec<kDim> vec;
+  static void Scale(double w, U& x) {
+    Vec<kDim, S> vec;
     x.Boxminus(Identity(), vec);
     vec *= w;
     Identity().Boxplus(vec, x);
   }
+  static bool IsActive(const U& /*x*/, int /*j*/) { return true; }
 };
 
 /*! \brief Array Trait.
- *         Element trait for array of specific sub-elements
+ *         Element trait for arrays A of N sub-elements of type T. Slots for which
+ *         IsSlotActive returns false (inactive slots of a BoundedArray) are passed
+ *         through by Boxplus and have zero difference and Jacobians.
  */
-template <typename T, size_t N>
-class ElementTraits<std::array<T, N>> {
+template <typename A, typename T, size_t N>
+class ArrayElementTraits {
  public:
   typedef ElementTraits<T> Traits;
-  using array = std::array<T, N>;
+  typedef typename Traits::Scalar Scalar;
+  using array = A;
   static constexpr int kElementDim = Traits::kDim;
   static constexpr int kDim = N * kElementDim;
   static std::string Print(const array& x) {
     std::ostringstream out;
-    for (const T& i : x) {
-      out << Traits::Print(i) << "\t";
+    for (size_t i = 0; i < N; i++) {
+      out << (IsSlotActive(x, i) ? Traits::Print(x.at(i)) : "-") << "\t";
     }
     return out.str();
   }
@@ -274,60 +293,93 @@ class ElementTraits<std::array<T, N>> {
       Traits::SetRandom(i);
     }
   }
-  static void Boxplus(const array& in, const VecCRef<kDim>& vec, array& out) {
+  static void Boxplus(const array& in, const VecCRef<kDim, Scalar>& vec, array& out) {
+    CopySlotActivity(in, out);
     for (size_t i = 0; i < N; i++) {
-      Traits::Boxplus(in.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0), out.at(i));
+      if (IsSlotActive(in, i)) {
+        Traits::Boxplus(in.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0), out.at(i));
+      } else {
+        out.at(i) = in.at(i);
+      }
     }
   }
-  static void Boxminus(const array& in, const array& ref, VecRef<kDim> vec) {
+  static void Boxminus(const array& in, const array& ref, VecRef<kDim, Scalar> vec) {
     for (size_t i = 0; i < N; i++) {
-      Traits::Boxminus(in.at(i), ref.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0));
+      if (IsSlotActive(in, i)) {
+        Traits::Boxminus(in.at(i), ref.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0));
+      } else {
+        vec.template block<kElementDim, 1>(i * kElementDim, 0).setZero();
+      }
     }
   }
-  static Mat<kDim> BoxplusJacInp(const array& in, const VecCRef<kDim>& vec) {
-    Mat<kDim> J = Mat<kDim>::Zero();
+  static Mat<kDim, kDim, Scalar> BoxplusJacInp(const array& in, const VecCRef<kDim, Scalar>& vec) {
+    Mat<kDim, kDim, Scalar> J = Mat<kDim, kDim, Scalar>::Identity();
     for (size_t i = 0; i < N; i++) {
-      J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) =
-          Traits::BoxplusJacInp(in.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0));
+      if (IsSlotActive(in, i)) {
+        J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) =
+            Traits::BoxplusJacInp(in.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0));
+      }
     }
     return J;
   }
-  static Mat<kDim> BoxplusJacVec(const array& in, const VecCRef<kDim>& vec) {
-    Mat<kDim> J = Mat<kDim>::Zero();
+  static Mat<kDim, kDim, Scalar> BoxplusJacVec(const array& in, const VecCRef<kDim, Scalar>& vec) {
+    Mat<kDim, kDim, Scalar> J = Mat<kDim, kDim, Scalar>::Zero();
     for (size_t i = 0; i < N; i++) {
-      J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) =
-          Traits::BoxplusJacVec(in.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0));
+      if (IsSlotActive(in, i)) {
+        J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) =
+            Traits::BoxplusJacVec(in.at(i), vec.template block<kElementDim, 1>(i * kElementDim, 0));
+      }
     }
     return J;
   }
-  static Mat<kDim> BoxminusJacInp(const array& in, const array& ref) {
-    Mat<kDim> J = Mat<kDim>::Zero();
+  static Mat<kDim, kDim, Scalar> BoxminusJacInp(const array& in, const array& ref) {
+    Mat<kDim, kDim, Scalar> J = Mat<kDim, kDim, Scalar>::Zero();
     for (size_t i = 0; i < N; i++) {
-      J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) = Traits::BoxminusJacInp(in.at(i), ref.at(i));
+      if (IsSlotActive(in, i)) {
+        J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) = Traits::BoxminusJacInp(in.at(i), ref.at(i));
+      }
     }
     return J;
   }
-  static Mat<kDim> BoxminusJacRef(const array& in, const array& ref) {
-    Mat<kDim> J = Mat<kDim>::Zero();
+  static Mat<kDim, kDim, Scalar> BoxminusJacRef(const array& in, const array& ref) {
+    Mat<kDim, kDim, Scalar> J = Mat<kDim, kDim, Scalar>::Zero();
     for (size_t i = 0; i < N; i++) {
-      J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) = Traits::BoxminusJacRef(in.at(i), ref.at(i));
+      if (IsSlotActive(in, i)) {
+        J.template block<kElementDim, kElementDim>(i * kElementDim, i * kElementDim) = Traits::BoxminusJacRef(in.at(i), ref.at(i));
+      }
     }
     return J;
   }
-  static Vec<kDim> GetVec(const array& x) {
-    Vec<kDim> vec;
+  static Vec<kDim, Scalar> GetVec(const array& x) {
+    Vec<kDim, Scalar> vec = Vec<kDim, Scalar>::Zero();
     for (size_t i = 0; i < N; i++) {
-      vec.template segment<kElementDim>(i * kElementDim) = x.at(i);
+      if (IsSlotActive(x, i)) {
+        vec.template segment<kElementDim>(i * kElementDim) = Traits::GetVec(x.at(i));
+      }
     }
     return vec;
   }
   static void Scale(double w, array& x) {
     for (size_t i = 0; i < N; i++) {
-      Traits::Scale(w, x.at(i));
+      if (IsSlotActive(x, i)) {
+        Traits::Scale(w, x.at(i));
+      }
     }
   }
+  static bool IsActive(const array& x, int j) {
+    return IsSlotActive(x, j / kElementDim) && Traits::IsActive(x.at(j / kElementDim), j % kElementDim);
+  }
 };
 
+template <typename T, size_t N>
+class ElementTraits<std::array<T, N>> : public ArrayElementTraits<std::array<T, N>, T, N> {};
+
+/*! \brief Bounded Array Trait.
+ *         Element trait for arrays with runtime activation of slots.
+ */
+template <typename T, size_t N>
+class ElementTraits<BoundedArray<T, N>> : public ArrayElementTraits<BoundedArray<T, N>, T, N> {};
+
 }  // namespace tsif
 
 #endif  // TSIF_ELEMENT_H_
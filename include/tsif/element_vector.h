@@ -7,16 +7,24 @@
 namespace tsif {
 
 template <typename... Elements>
-struct DimensionTrait;
-template <>
-struct DimensionTrait<> {
-  static const int kDim = 0;
+struct DimensionTrait {
+  static const int kDim = (0 + ... + Elements::kDim);
+};
+
+template <typename... Elements>
+struct ScalarTrait {
+  typedef double Type;
 };
 template <typename Element, typename... Elements>
-struct DimensionTrait<Element, Elements...> {
-  static const int kDim = Element::kDim + DimensionTrait<Elements...>::kDim;
+struct ScalarTrait<Element, Elements...> {
+  typedef typename Element::Scalar Type;
+  static_assert((std::is_same<typename Elements::Scalar, Type>::value && ...), "Elements with different scalar types");
 };
 
+/*! \brief Tag for views which index the referenced elements in their own compact layout (see ElementVectorConstRef).
+ */
+struct CompactLayout {};
+
 template <typename Derived, typename... Elements>
 class ElementVectorBase {
  private:
@@ -24,15 +32,26 @@ class ElementVectorBase {
 
  public:
   static const int kN = sizeof...(Elements);
-
-  template <int I, int C = 0, typename std::enable_if<(std::tuple_element<C, Tuple>::type::kI == I)>::type* = nullptr>
-  static constexpr int GetC() {
-    return C;
+  typedef typename ScalarTrait<Elements...>::Type Scalar;
+
+  static constexpr std::array<int, sizeof...(Elements)> kIds{{Elements::kI...}};
+  static constexpr std::array<int, sizeof...(Elements)> kDims{{Elements::kDim...}};
+
+  /*! \brief Position of the element with index I in the vector (-1 if not contained).
+   */
+  static constexpr int FindC(int I) {
+    for (int c = 0; c < kN; c++) {
+      if (kIds[c] == I) {
+        return c;
+      }
+    }
+    return -1;
   }
-  template <int I, int C = 0, typename std::enable_if<((std::tuple_element<C, Tuple>::type::kI != I))>::type* = nullptr>
+
+  template <int I>
   static constexpr int GetC() {
-    static_assert(C < kN - 1, "Index not found in ElementVector");
-    return GetC<I, C + 1>();
+    static_assert(FindC(I) >= 0, "Index not found in ElementVector");
+    return FindC(I);
   }
 
   template <int I>
@@ -53,106 +72,102 @@ class ElementVectorBase {
     return static_cast<const Derived&>(*this).template GetElement<I>();
   }
 
-  template <typename Element, int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  static constexpr bool HasElement() {
-    return std::is_same<typename std::tuple_element<C, Tuple>::type, Element>::value ? true : HasElement<Element, C + 1>();
-  }
-  template <typename Element, int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
+  template <typename Element>
   static constexpr bool HasElement() {
-    return false;
+    return (std::is_same<Elements, Element>::value || ...);
   }
 
-  template <int I, int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  static constexpr bool HasId() {
-    return std::tuple_element<C, Tuple>::type::kI == I ? true : HasId<I, C + 1>();
-  }
-  template <int I, int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
+  template <int I>
   static constexpr bool HasId() {
-    return false;
+    return FindC(I) >= 0;
   }
 
   template <int C>
   static constexpr int GetId() {
-    return std::tuple_element<C, Tuple>::type::kI;
+    return kIds[C];
   }
 
   template <int I>
   static constexpr int GetElementDim() {
-    return std::tuple_element<GetC<I>(), Tuple>::type::kDim;
+    return kDims[GetC<I>()];
+  }
+
+  /*! \brief Start of the element with index I if the elements are stored contiguously (-1 if not contained).
+   */
+  static constexpr int CompactStart(int I) {
+    int start = 0;
+    for (int c = 0; c < kN; c++) {
+      if (kIds[c] == I) {
+        return start;
+      }
+      start += kDims[c];
+    }
+    return -1;
   }
+  static constexpr int CompactDim() { return DimensionTrait<Elements...>::kDim; }
 
-  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  std::string Print() const {
-    return GetElement<GetId<C>()>().Print() + "\n" + Print<C + 1>();
-  }
-  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
   std::string Print() const {
-    return "";
+    std::string out;
+    ((out += GetElement<Elements::kI>().Print() + "\n"), ...);
+    return out;
   }
 
-  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void SetIdentity() {
-    GetElement<GetId<C>()>().SetIdentity();
-    SetIdentity<C + 1>();
+  void SetIdentity() { (GetElement<Elements::kI>().SetIdentity(), ...); }
+
+  void SetRandom() { (GetElement<Elements::kI>().SetRandom(), ...); }
+
+  template <typename OtherDerived>
+  void Boxplus(const VecCRef<-1, Scalar>& vec, ElementVectorBase<OtherDerived, Elements...>& out) const {
+    assert(vec.size() == Dim());
+    (BoxplusElement<Elements>(vec, out), ...);
   }
-  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void SetIdentity() {}
 
-  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void SetRandom() {
-    GetElement<GetId<C>()>().SetRandom();
-    SetRandom<C + 1>();
+  template <typename OtherDerived>
+  void Boxminus(const ElementVectorBase<OtherDerived, Elements...>& ref, VecRef<-1, Scalar> out) const {
+    assert(out.size() == Dim());
+    (BoxminusElement<Elements>(ref, out), ...);
   }
-  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void SetRandom() {}
 
-  template <typename OtherDerived, int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void Boxplus(const VecCRefX& vec, ElementVectorBase<OtherDerived, Elements...>& out) const {
+  void GetVec(VecRef<-1, Scalar> vec) const {
     assert(vec.size() == Dim());
-    typedef typename std::tuple_element<C, Tuple>::type E;
+    (GetVecElement<Elements>(vec), ...);
+  }
+
+  void Scale(double w) { (GetElement<Elements::kI>().Scale(w), ...); }
+
+  /*! \brief Collects the indices of all active coordinates (see ElementTraits::IsActive).
+   */
+  void GetActiveIndices(std::vector<int>& indices) const { (GetActiveIndicesElement<Elements>(indices), ...); }
+
+  int Start(int I) const { return static_cast<const Derived&>(*this).Start(I); }
+  int Dim() const { return static_cast<const Derived&>(*this).Dim(); }
+ private:
+  template <typename E, typename OtherDerived>
+  void BoxplusElement(const VecCRef<-1, Scalar>& vec, ElementVectorBase<OtherDerived, Elements...>& out) const {
     if (E::kDim > 0) {
       GetElement<E::kI>().Boxplus(vec.template block<E::kDim, 1>(Start(E::kI), 0), out.template GetElement<E::kI>());
     }
-    Boxplus<OtherDerived, C + 1>(vec, out);
   }
-  template <typename OtherDerived, int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void Boxplus(const VecCRefX& /*vec*/, ElementVectorBase<OtherDerived, Elements...>& /*out*/) const {}
-
-  template <typename OtherDerived, int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void Boxminus(const ElementVectorBase<OtherDerived, Elements...>& ref, VecRefX out) const {
-    assert(out.size() == Dim());
-    typedef typename std::tuple_element<C, Tuple>::type E;
+  template <typename E, typename OtherDerived>
+  void BoxminusElement(const ElementVectorBase<OtherDerived, Elements...>& ref, VecRef<-1, Scalar> out) const {
     if (E::kDim > 0) {
       GetElement<E::kI>().Boxminus(ref.template GetElement<E::kI>(), out.template block<E::kDim, 1>(Start(E::kI), 0));
     }
-    Boxminus<OtherDerived, C + 1>(ref, out);
   }
-  template <typename OtherDerived, int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void Boxminus(const ElementVectorBase<OtherDerived, Elements...>& /*ref*/, VecRefX /*out*/) const {}
-
-  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void GetVec(VecRefX vec) const {
-    assert(vec.size() == Dim());
-    typedef typename std::tuple_element<C, Tuple>::type E;
+  template <typename E>
+  void GetVecElement(VecRef<-1, Scalar> vec) const {
     if (E::kDim > 0) {
       vec.template block<E::kDim, 1>(Start(E::kI), 0) = GetElement<E::kI>().GetVec();
     }
-    GetVec<C + 1>(vec);
   }
-  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void GetVec(VecRefX /*vec*/) const {}
-
-  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void Scale(double w) {
-    typedef typename std::tuple_element<C, Tuple>::type E;
-    GetElement<E::kI>().Scale(w);
-    Scale<C + 1>(w);
+  template <typename E>
+  void GetActiveIndicesElement(std::vector<int>& indices) const {
+    for (int j = 0; j < E::kDim; j++) {
+      if (GetElement<E::kI>().IsActive(j)) {
+        indices.push_back(Start(E::kI) + j);
+      }
+    }
   }
-  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void Scale(double /*w*/) {}
-
-  int Start(int I) const { return static_cast<const Derived&>(*this).Start(I); }
-  int Dim() const { return static_cast<const Derived&>(*this).Dim(); }
 };
 
 template <typename... Elements>
@@ -211,6 +226,13 @@ class ElementVectorConstRef : public ElementVectorBase<ElementVectorConstRef<Ele
       : elements_(elementVector.template GetElement<Elements::kI>()...),
         startMap_{std::make_pair(Elements::kI, elementVector.Start(Elements::kI))...},
         Dim_(elementVector.Dim()) {}
+  /*! \brief View whose Start and Dim refer to the compact layout of Elements instead of the referenced vector.
+   */
+  template <typename OtherDerived, typename... OtherElements>
+  ElementVectorConstRef(const ElementVectorBase<OtherDerived, OtherElements...>& elementVector, CompactLayout)
+      : elements_(elementVector.template GetElement<Elements::kI>()...),
+        startMap_{std::make_pair(Elements::kI, Base::CompactStart(Elements::kI))...},
+        Dim_(Base::CompactDim()) {}
   ~ElementVectorConstRef() = default;
 
   template <int I>
@@ -264,16 +286,22 @@ class ElementVector : public ElementVectorBase<ElementVector<Elements...>, Eleme
   const typename std::tuple_element<Base::template GetC<I>(), Tuple>::type& GetElement() const {
     return std::get<Base::template GetC<I>()>(elements_);
   }
-  static constexpr int Start(int I) { return _Start<0>(I); }
-  template <int C = 0, int kNInternal = kN, typename std::enable_if<(C < kNInternal)>::type* = nullptr>
-  static constexpr int _Start(int I) {
-    return (std::tuple_element<C, Tuple>::type::kI == I) ? 0 : std::tuple_element<C, Tuple>::type::kDim + _Start<C + 1>(I);
-  }
-  template <int C = 0, int kNInternal = kN, typename std::enable_if<(C >= kNInternal)>::type* = nullptr>
-  static constexpr int _Start(int /*I*/) {
-    return -1;
-  }
-  static constexpr int Dim() { return DimensionTrait<Elements...>::kDim; }
+  static constexpr int Start(int I) { return Base::CompactStart(I); }
+  static constexpr int Dim() { return Base::CompactDim(); }
+};
+
+/*! \brief Scalar type of the first non-empty element vector (double if all are empty).
+ */
+template <typename... ElementVectors>
+struct ElementVectorScalarTrait;
+template <>
+struct ElementVectorScalarTrait<> {
+  typedef double Type;
+};
+template <typename ElementVector, typename... ElementVectors>
+struct ElementVectorScalarTrait<ElementVector, ElementVectors...> {
+  typedef typename std::conditional<(ElementVector::kN > 0), typename ElementVector::Scalar,
+                                    typename ElementVectorScalarTrait<ElementVectors...>::Type>::type Type;
 };
 
 template <typename ElementVector, typename Element, bool DoAddition = true>
@@ -287,31 +315,52 @@ struct AddElementTrait<ElementVector<Elements...>, Element, false> {
   typedef ElementVector<Elements...> Type;
 };
 
-template <typename ElementVectorA, typename ElementVectorB>
-struct MergeTwo;
+/*! \brief Merges element vectors into one, keeping the first occurrence of every element.
+ *         Elements are deduplicated in a single pass via a constexpr table of their indices.
+ */
+template <typename Tuple, typename Sequence>
+struct MergeTupleTrait;
+template <typename... Elements, size_t... Ks>
+struct MergeTupleTrait<std::tuple<Elements...>, std::index_sequence<Ks...>> {
+  static constexpr std::array<int, sizeof...(Elements)> kIds{{Elements::kI...}};
+  static constexpr size_t First(size_t k) {
+    for (size_t j = 0; j < k; j++) {
+      if (kIds[j] == kIds[k]) {
+        return j;
+      }
+    }
+    return k;
+  }
+  static_assert((std::is_same<Elements, typename std::tuple_element<First(Ks), std::tuple<Elements...>>::type>::value && ...),
+                "Conflicting Merge");
+  typedef decltype(std::tuple_cat(
+      std::declval<typename std::conditional<First(Ks) == Ks, std::tuple<Elements>, std::tuple<>>::type>()...)) Type;
+};
 
+template <typename Tuple>
+struct TupleToElementVector;
 template <typename... Elements>
-struct MergeTwo<ElementVector<Elements...>, ElementVector<>> {
+struct TupleToElementVector<std::tuple<Elements...>> {
   typedef ElementVector<Elements...> Type;
 };
-template <typename Element, typename... ElementsA, typename... ElementsB>
-struct MergeTwo<ElementVector<ElementsA...>, ElementVector<Element, ElementsB...>> {
-  static_assert(!ElementVector<ElementsA...>::template HasId<Element::kI>() | ElementVector<ElementsA...>::template HasElement<Element>(),
-                "Conflicting Merge");
-  typedef typename MergeTwo<
-      typename AddElementTrait<ElementVector<ElementsA...>, Element, !ElementVector<ElementsA...>::template HasElement<Element>()>::Type,
-      ElementVector<ElementsB...>>::Type Type;
+
+template <typename ElementVector>
+struct ElementTupleTrait;
+template <typename... Elements>
+struct ElementTupleTrait<ElementVector<Elements...>> {
+  typedef std::tuple<Elements...> Type;
 };
 
 template <typename... ElementVectors>
-struct MergeTrait;
-template <typename ElementVector>
-struct MergeTrait<ElementVector> {
-  typedef ElementVector Type;
+struct MergeTrait {
+  typedef decltype(std::tuple_cat(std::declval<typename ElementTupleTrait<ElementVectors>::Type>()...)) Tuple;
+  typedef typename TupleToElementVector<
+      typename MergeTupleTrait<Tuple, std::make_index_sequence<std::tuple_size<Tuple>::value>>::Type>::Type Type;
 };
-template <typename ElementVectorA, typename ElementVectorB, typename... ElementVectors>
-struct MergeTrait<ElementVectorA, ElementVectorB, ElementVectors...> {
-  typedef typename MergeTrait<typename MergeTwo<ElementVectorA, ElementVectorB>::Type, ElementVectors...>::Type Type;
+
+template <typename ElementVectorA, typename ElementVectorB>
+struct MergeTwo {
+  typedef typename MergeTrait<ElementVectorA, ElementVectorB>::Type Type;
 };
 
 class MeasEmpty : public ElementVector<> {};
@@ -3,27 +3,132 @@
 
 #include "tsif/residual.h"
 #include "tsif/timeline.h"
+#include "tsif/utils/background_worker.h"
+#include "tsif/utils/parallel_dense.h"
+#include "tsif/utils/snapshot_buffer.h"
+#include "tsif/utils/thread_pool.h"
 #include "tsif/utils/common.h"
 
 namespace tsif {
 
+template <typename FilterType>
+class BatchFilter;
+
 template <typename... Residuals>
 class Filter {
+  template <typename FilterType>
+  friend class BatchFilter;
+
  public:
   static constexpr int kN = sizeof...(Residuals);
   typedef typename MergeTrait<typename Residuals::Previous..., typename Residuals::Current...>::Type State;
+  typedef typename State::Scalar Scalar;
+  typedef Mat<-1, -1, Scalar> MatX;
+  typedef Vec<-1, Scalar> VecX;
+  template <int I>
+  using StateElementType = typename std::decay<decltype(std::declval<State&>().template Get<I>())>::type;
   typedef std::tuple<Residuals...> ResidualTuple;
   typedef std::tuple<Timeline<typename Residuals::Measurement>...> TimelineTuple;
+  typedef std::tuple<std::shared_ptr<const typename Residuals::Measurement>...> MeasurementTuple;
+  /*! \brief Estimate published after every update step, see GetSnapshot.
+   */
+  struct Snapshot {
+    TimePoint time_;
+    State state_;
+    MatX information_;                    // Information matrix, only published if covariance blocks are selected
+    std::vector<int> covarianceIndices_;  // Coordinates selected by AddSnapshotCovarianceBlock
+    /*! \brief Joint covariance of the selected coordinates. Computed from information_ by the reader, such that the
+     *         factorization does not delay the update steps.
+     */
+    MatX GetCovariance() const {
+      if (covarianceIndices_.empty()) {
+        return MatX();
+      }
+      MatX E = MatX::Zero(information_.rows(), covarianceIndices_.size());
+      for (size_t j = 0; j < covarianceIndices_.size(); j++) {
+        E(covarianceIndices_[j], j) = Scalar(1);
+      }
+      return information_.llt().solve(E)(covarianceIndices_, Eigen::all);
+    }
+  };
+  /*! \brief Measurements of an update step, fetched from the timelines ahead of the step (see StageMeasurements).
+   */
+  struct StagedStep {
+    TimePoint time_;
+    TimePoint previous_;
+    MeasurementTuple meas_;  // nullptr if the residual has no measurement at time_
+  };
+  /*! \brief Accumulated wall time of the update stages, see SetPipelining.
+   */
+  struct PipelineStats {
+    int steps_ = 0;
+    double stageTime_ = 0;  // Splitting, merging and fetching the measurements of the steps
+    double solveTime_ = 0;  // Residual evaluation, factorization and state update
+    double waitTime_ = 0;   // Solve stage waiting for the staging of the next step
+    double wallTime_ = 0;
+    double GetStageOccupancy() const { return wallTime_ > 0 ? stageTime_ / wallTime_ : 0; }
+    double GetSolveOccupancy() const { return wallTime_ > 0 ? solveTime_ / wallTime_ : 0; }
+  };
+  /*! \brief Columns of the compact Jacobian of a residual (see EvaluateResidual) which belong to the problem, and their
+   *         positions in the problem. These are the active coordinates if the problem is reduced (see IsReduced).
+   */
+  struct ProblemColumns {
+    std::vector<int> preCols_;
+    std::vector<int> pre_;
+    std::vector<int> curCols_;
+    std::vector<int> cur_;
+  };
   ResidualTuple residuals_;
   TimelineTuple timelines_;
 
-  Filter() : timelines_(Timeline<typename Residuals::Measurement>(fromSec(0.1), fromSec(0.0))...), I_(State::Dim(), State::Dim()) {
+  Filter()
+      : timelines_(Timeline<typename Residuals::Measurement>(fromSec(0.1), fromSec(0.0))...),
+        I_(State::Dim(), State::Dim()),
+        isPredictionResidual_{{(Residuals::Previous::kN > 0)...}} {
     is_initialized_ = false;
     include_max_ = false;
     max_iter_ = 1;
     th_iter_ = 0.1;
     iter_ = 0;
     weightedDelta_ = 0;
+    isPipelining_ = false;
+    isGramConstant_.fill(false);
+    isUsed_.fill(false);
+    isGatingDinvHpcValid_ = false;
+    parallelDenseDim_ = 150;
+    isPredictionValid_ = false;
+    accumulatedCost_ = 0;
+    isInnovationScored_ = false;
+  }
+  /*! \brief Copies the estimate, the timelines and the configuration. The timelines are shared copy-on-write and the
+   *         update workspace is not copied, such that clones (e.g. hypotheses, see EvaluateHypotheses) are cheap.
+   *         Only the stateless threadPool_ is shared, a pipelined clone creates its own staging worker when needed.
+   */
+  Filter(const Filter& other)
+      : residuals_(other.residuals_),
+        timelines_(other.timelines_),
+        is_initialized_(other.is_initialized_),
+        include_max_(other.include_max_),
+        startTime_(other.startTime_),
+        time_(other.time_),
+        state_(other.state_),
+        curLinState_(other.curLinState_),
+        I_(other.I_),
+        accumulatedCost_(other.accumulatedCost_),
+        isInnovationScored_(other.isInnovationScored_),
+        threadPool_(other.threadPool_),
+        parallelDenseDim_(other.parallelDenseDim_),
+        isPipelining_(other.isPipelining_),
+        snapshotIndices_(other.snapshotIndices_),
+        isPredictionResidual_(other.isPredictionResidual_),
+        max_iter_(other.max_iter_),
+        iter_(other.iter_),
+        weightedDelta_(other.weightedDelta_),
+        th_iter_(other.th_iter_) {
+    isGramConstant_.fill(false);
+    isUsed_.fill(false);
+    isGatingDinvHpcValid_ = false;
+    isPredictionValid_ = false;
   }
   virtual ~Filter() {}
 
@@ -31,6 +136,9 @@ class Filter {
   void AddMeas(TimePoint t, std::shared_ptr<const typename std::tuple_element<N, ResidualTuple>::type::Measurement> m) {
     TSIF_LOGWIF(t < time_, "Warning: adding measurement in past!");
     TSIF_LOGWIF(is_initialized_ && (t - time_ > fromSec(10)), "Warning: measurement far in future!");
+    if (isPredictionValid_ && t <= predictionTime_) {
+      isPredictionValid_ = false;  // Late measurement within the cached propagation
+    }
     std::get<N>(timelines_).Add(t, m);
   }
 
@@ -133,6 +241,7 @@ class Filter {
       state_.SetIdentity();
       I_.setIdentity();
       is_initialized_ = true;
+      isPredictionValid_ = false;
     }
   }
   virtual void ComputeLinearizationPoint(const TimePoint& /*t*/) { curLinState_ = state_; }
@@ -140,6 +249,29 @@ class Filter {
   virtual void PostProcess() {};
 
   void Update() {
+    std::set<TimePoint> times;
+    PrepareUpdate(times);
+
+    // Carry out updates
+    RunUpdateSteps(times);
+    Clean(time_);
+  }
+
+  /*! \brief Would Update() initialize the filter or carry out an update step.
+   */
+  bool HasPendingUpdate() {
+    if (!is_initialized_) {
+      return GetMinMaxTime() != TimePoint::min();
+    }
+    std::set<TimePoint> times;
+    GetTimeList(times, GetMaxUpdateTime(GetCurrentTime()), include_max_);
+    return !times.empty();
+  }
+
+  /*! \brief Initializes if required and returns the update times. The measurements are split and merged at these
+   *         step by step (see PrepareStep).
+   */
+  void PrepareUpdate(std::set<TimePoint>& times) {
     // TODO(unassigned): It is not understandable why this function tries to initialize here.
     if (!is_initialized_) {
       Init(GetMaxMinTime());
@@ -148,113 +280,601 @@ class Filter {
     TimePoint current = GetCurrentTime();
     TimePoint maxUpdateTime = GetMaxUpdateTime(current);
 
-    std::set<TimePoint> times;
     GetTimeList(times, maxUpdateTime, include_max_);
-    SplitAndMerge(time_, times);
+  }
 
-    // Carry out updates
-    for (const auto& t : times) {
-      MakeUpdateStep(t);
+  /*! \brief Splits and merges the measurements of the update step from previous to t and stages them. Only the
+   *         timelines after previous are modified, such that a step can be prepared while the earlier ones are solved.
+   *         Step by step this is the same as splitting and merging at all update times at once.
+   */
+  void PrepareStep(TimePoint t, TimePoint previous, StagedStep& staged) {
+    SplitAndMerge(previous, std::set<TimePoint>{t});
+    StageMeasurements(t, previous, staged);
+  }
+
+  /*! \brief Carries out the update steps at times. Each step is prepared first (see PrepareStep), with pipelining
+   *         enabled the preparation of the next step runs on stagingWorker_ (created on first use) while the current
+   *         step is solved.
+   */
+  void RunUpdateSteps(const std::set<TimePoint>& times) {
+    if (times.empty()) {
+      return;
     }
-    Clean(time_);
+    Timer wall;
+    std::array<StagedStep, 2> staged;
+    auto stage = [this, &staged](int k, TimePoint t, TimePoint previous) {
+      Timer timer;
+      PrepareStep(t, previous, staged[k % 2]);
+      pipelineStats_.stageTime_ += timer.GetFull();
+    };
+    if (isPipelining_ && stagingWorker_ == nullptr && times.size() > 1) {
+      stagingWorker_ = std::make_shared<BackgroundWorker>();
+    }
+    stage(0, *times.begin(), time_);
+    int k = 0;
+    for (auto it = times.begin(); it != times.end(); ++it, ++k) {
+      const auto next = std::next(it);
+      const bool isOverlapped = isPipelining_ && next != times.end();
+      if (isOverlapped) {
+        stagingWorker_->Post([&stage, k, it, next]() { stage(k + 1, *next, *it); });
+      }
+      Timer solve;
+      MakeStagedUpdateStep(staged[k % 2]);
+      pipelineStats_.solveTime_ += solve.GetFull();
+      if (isOverlapped) {
+        Timer wait;
+        stagingWorker_->Wait();
+        pipelineStats_.waitTime_ += wait.GetFull();
+      } else if (next != times.end()) {
+        stage(k + 1, *next, *it);
+      }
+    }
+    pipelineStats_.steps_ += k;
+    pipelineStats_.wallTime_ += wall.GetFull();
   }
 
   void MakeUpdateStep(TimePoint t) {
+    StagedStep staged;
+    PrepareStep(t, time_, staged);
+    MakeStagedUpdateStep(staged);
+  }
+
+  void MakeStagedUpdateStep(const StagedStep& staged) {
+    BeginUpdateStep(staged);
+    while (IsIterating()) {
+      AssembleIteration();
+      SolveIteration();
+      ApplyIteration();
+    }
+    FinishUpdateStep(staged.time_);
+  }
+
+  /*! \brief Phases of an update step (see MakeStagedUpdateStep), separate such that BatchFilter can run the dense solve
+   *         of several filters in lockstep.
+   */
+  void BeginUpdateStep(const StagedStep& staged) {
     // Compute linearisation point
-    ComputeLinearizationPoint(t);
+    ComputeLinearizationPoint(staged.time_);
 
     // Check available measurements and prepare residuals
-    int innDim = PreProcessResidual(t);
+    PreProcessResidual(staged);
     PreProcess();
 
-    // Temporaries
-    y_.resize(innDim);
-    y_.setZero();
-    JacPre_.resize(innDim, State::Dim());
-    JacPre_.setZero();
-    JacCur_.resize(innDim, State::Dim());
-    JacCur_.setZero();
-
+    // Restrict the problem to the active coordinates of the state (see BoundedArray)
+    activeIndices_.clear();
+    curLinState_.GetActiveIndices(activeIndices_);
+    if (IsReduced()) {
+      DecoupleInactiveCoordinates();
+      activeI_ = I_(activeIndices_, activeIndices_);
+    }
+    SetProblemColumns(std::make_index_sequence<kN>());
     weightedDelta_ = th_iter_;
-    MatX newInf(State::Dim(), State::Dim());
-    for (iter_ = 0; iter_ < max_iter_ && weightedDelta_ >= th_iter_; iter_++) {
-      ConstructProblem(0);
-      TSIF_LOG("Innovation:\t" << y_.transpose());
-      TSIF_LOG("JacPre:\n" << JacPre_);
-      TSIF_LOG("JacCur:\n" << JacCur_);
-
-      // Compute Kalman Update // TODO use more efficient form
-      MatX D = I_ + JacPre_.transpose() * JacPre_;
-      MatX J(innDim, innDim);
-      J.setIdentity();
-#if TSIF_VERBOSE > 0
-      Eigen::JacobiSVD<MatX> svdD(D);
-      const double condD = svdD.singularValues()(0) / svdD.singularValues()(svdD.singularValues().size() - 1);
-      TSIF_LOG("D condition number:\n" << condD);
-#endif
-      MatX S = JacCur_.transpose() * (J - JacPre_ * D.inverse() * JacPre_.transpose());
-      newInf = S * JacCur_;
-      newInf = 0.5 * (newInf + newInf.transpose().eval());
-      Eigen::LDLT<MatX> I_LDLT(newInf);
-#if TSIF_VERBOSE > 0
-      Eigen::JacobiSVD<MatX> svdI(newInf);
-      const double condI = svdI.singularValues()(0) / svdI.singularValues()(svdI.singularValues().size() - 1);
-      TSIF_LOG("I condition number:\n" << condI);
-#endif
-      TSIF_LOGEIF((I_LDLT.info() != Eigen::Success), "Computation of Iinv failed");
-      VecX dx = -I_LDLT.solve(S * y_);
-
-      // Apply Kalman Update
-      State newState = curLinState_;
-      curLinState_.Boxplus(dx, newState);
-      curLinState_ = newState;
-      weightedDelta_ = sqrt((dx.dot(newInf * dx)) / dx.size());
-      TSIF_LOG("iter: " << iter_ << "\tw: " << sqrt((dx.dot(dx)) / dx.size()) << "\twd: " << weightedDelta_);
+    iter_ = 0;
+  }
+  bool IsIterating() const { return iter_ < max_iter_ && weightedDelta_ >= th_iter_; }
+  bool IsReduced() const { return static_cast<int>(activeIndices_.size()) < State::Dim(); }
+  /*! \brief Accumulates the problem of the current iteration. With a reduced problem (IsReduced) it is assembled
+   *         directly on the active coordinates, such that the assembly scales with the active slots as well.
+   */
+  void AssembleIteration() {
+    linearizationCache_.Invalidate();
+    isGatingDinvHpcValid_ = false;
+    ResetProblem();
+    [[maybe_unused]] const int innDim = ConstructProblem();
+    TSIF_LOG("Innovation dimension:\t" << innDim);
+    TSIF_LOG("Hpp:\n" << (IsReduced() ? activeHpp_ : Hpp_));
+    TSIF_LOG("Hpc:\n" << (IsReduced() ? activeHpc_ : Hpc_));
+    TSIF_LOG("Hcc:\n" << (IsReduced() ? activeHcc_ : Hcc_));
+  }
+  /*! \brief Zeroes the Gram blocks and gradients of the problem (the active ones if IsReduced).
+   */
+  void ResetProblem() {
+    if (IsReduced()) {
+      const int m = activeIndices_.size();
+      activeHpp_.setZero(m, m);
+      activeHpc_.setZero(m, m);
+      activeHcc_.setZero(m, m);
+      activeBp_.setZero(m);
+      activeBc_.setZero(m);
+    } else {
+      Hpp_.setZero(State::Dim(), State::Dim());
+      Hpc_.setZero(State::Dim(), State::Dim());
+      Hcc_.setZero(State::Dim(), State::Dim());
+      bp_.setZero(State::Dim());
+      bc_.setZero(State::Dim());
+    }
+  }
+  void SolveIteration() {
+    // Compute Kalman Update, the previous state is marginalized via the Schur complement of D
+    const bool isReduced = IsReduced();
+    const MatX& I = isReduced ? activeI_ : I_;
+    const MatX& Hpp = isReduced ? activeHpp_ : Hpp_;
+    const MatX& Hpc = isReduced ? activeHpc_ : Hpc_;
+    const MatX& Hcc = isReduced ? activeHcc_ : Hcc_;
+    const VecX& bp = isReduced ? activeBp_ : bp_;
+    const VecX& bc = isReduced ? activeBc_ : bc_;
+    const bool isParallelDense =
+        threadPool_ != nullptr && threadPool_->GetNumThreads() > 1 && I.rows() >= parallelDenseDim_;
+    if (!isParallelDense || !ComputeUpdateParallel(I, Hpp, Hpc, Hcc, bp, bc, updateInf_, updateDx_)) {
+      ComputeUpdate(I, Hpp, Hpc, Hcc, bp, bc, updateInf_, updateDx_, isGatingDinvHpcValid_ ? &gatingDinvHpc_ : nullptr);
+    }
+  }
+  void ApplyIteration() {
+    const VecX& dx = updateDx_;
+    VecX dxFull;
+    if (IsReduced()) {
+      dxFull.setZero(State::Dim());
+      dxFull(activeIndices_) = dx;
     }
+
+    // Apply Kalman Update
+    State newState = curLinState_;
+    curLinState_.Boxplus(IsReduced() ? dxFull : dx, newState);
+    curLinState_ = newState;
+    weightedDelta_ = std::sqrt(double(dx.dot(updateInf_ * dx)) / dx.size());
+    TSIF_LOG("iter: " << iter_ << "\tw: " << std::sqrt(double(dx.dot(dx)) / dx.size()) << "\twd: " << weightedDelta_);
+    iter_++;
+  }
+  void FinishUpdateStep(TimePoint t) {
     TSIF_LOGWIF(weightedDelta_ >= th_iter_, "Reached maximal iterations:" << iter_);
 
     state_ = curLinState_;
-    I_ = newInf;
+    if (IsReduced()) {
+      ScatterActiveInformation(updateInf_);
+    } else {
+      I_ = updateInf_;
+    }
     TSIF_LOG("State after Update:\n" << state_.Print());
     TSIF_LOG("Information matrix:\n" << I_);
 
     // Post Processing
     PostProcess();
     time_ = t;
+    isPredictionValid_ = false;
+    PublishSnapshot();
+  }
+
+  /*! \brief Publishes time_, state_ and, if covariance blocks are selected, I_ for GetSnapshot. The covariance is left
+   *         to the readers (Snapshot::GetCovariance), the update step only copies into a free slot.
+   */
+  void PublishSnapshot() {
+    snapshots_.Publish([&](Snapshot& snapshot) {
+      snapshot.time_ = time_;
+      snapshot.state_ = state_;
+      snapshot.covarianceIndices_ = snapshotIndices_;
+      if (snapshotIndices_.empty()) {
+        snapshot.information_.resize(0, 0);
+      } else {
+        snapshot.information_ = I_;
+      }
+    });
+  }
+
+  /*! \brief Information newInf of the current state after marginalizing the previous one, and the update dx. D^-1 * Hpc
+   *         is taken from precomputedDinvHpc if set (see EvaluateInnovations).
+   */
+  void ComputeUpdate(const MatX& I, const MatX& Hpp, const MatX& Hpc, const MatX& Hcc, const VecX& bp, const VecX& bc,
+                     MatX& newInf, VecX& dx, const MatX* precomputedDinvHpc = nullptr) const {
+    MatX computedDinvHpc;
+    if (precomputedDinvHpc == nullptr) {
+      MatX D = I + Hpp;
+#if TSIF_VERBOSE > 0
+      Eigen::JacobiSVD<MatX> svdD(D);
+      const Scalar condD = svdD.singularValues()(0) / svdD.singularValues()(svdD.singularValues().size() - 1);
+      TSIF_LOG("D condition number:\n" << condD);
+#endif
+      Eigen::LDLT<MatX> D_LDLT(D);
+      TSIF_LOGEIF((D_LDLT.info() != Eigen::Success), "Computation of Dinv failed");
+      computedDinvHpc = D_LDLT.solve(Hpc);
+    }
+    const MatX& DinvHpc = precomputedDinvHpc != nullptr ? *precomputedDinvHpc : computedDinvHpc;
+    newInf = Hcc - Hpc.transpose() * DinvHpc;
+    newInf = Scalar(0.5) * (newInf + newInf.transpose().eval());
+    Eigen::LDLT<MatX> I_LDLT(newInf);
+#if TSIF_VERBOSE > 0
+    Eigen::JacobiSVD<MatX> svdI(newInf);
+    const Scalar condI = svdI.singularValues()(0) / svdI.singularValues()(svdI.singularValues().size() - 1);
+    TSIF_LOG("I condition number:\n" << condI);
+#endif
+    TSIF_LOGEIF((I_LDLT.info() != Eigen::Success), "Computation of Iinv failed");
+    dx = -I_LDLT.solve(bc - DinvHpc.transpose() * bp);
+  }
+
+  /*! \brief Same as ComputeUpdate with the blocked kernels of parallel_dense.h on threadPool_. Uses Cholesky
+   *         factorizations D = L*L^T and newInf = L'*L'^T, such that newInf = Hcc - Y^T*Y with Y = L^-1*Hpc. Returns false
+   *         if a factorization fails (the caller then falls back to ComputeUpdate).
+   */
+  bool ComputeUpdateParallel(const MatX& I, const MatX& Hpp, const MatX& Hpc, const MatX& Hcc, const VecX& bp,
+                             const VecX& bc, MatX& newInf, VecX& dx) const {
+    ThreadPool& pool = *threadPool_;
+    MatX L = I + Hpp;
+    if (!ParallelLLT(pool, L)) {
+      return false;
+    }
+    MatX Y = Hpc;
+    ParallelLowerSolve(pool, L, Y);
+    const VecX z = L.template triangularView<Eigen::Lower>().solve(bp);
+    newInf = Hcc;
+    ParallelSubtractGram(pool, Y, newInf);
+    MatX L_inf = newInf;
+    if (!ParallelLLT(pool, L_inf)) {
+      return false;
+    }
+    const VecX grad = bc - Y.transpose() * z;
+    dx = -L_inf.transpose().template triangularView<Eigen::Upper>().solve(
+        L_inf.template triangularView<Eigen::Lower>().solve(grad));
+    return true;
   }
 
+  /*! \brief Inactive coordinates of the state, i.e. the complement of activeIndices_.
+   */
+  std::vector<int> GetInactiveIndices() const {
+    std::vector<int> inactiveIndices;
+    for (int i = 0, j = 0; i < State::Dim(); i++) {
+      if (j < static_cast<int>(activeIndices_.size()) && activeIndices_[j] == i) {
+        j++;
+      } else {
+        inactiveIndices.push_back(i);
+      }
+    }
+    return inactiveIndices;
+  }
+
+  /*! \brief Splits I_ into the marginal information of the active and of the inactive coordinates if they are coupled
+   *         (e.g. a slot which has been deactivated without MarginalizeSlot). The active block is then the Schur
+   *         complement I_aa - I_ai * I_ii^-1 * I_ia and the inactive block I_ii - I_ia * I_aa^-1 * I_ai. Inactive
+   *         coordinates are frozen, so keeping the coupling would claim information which is never applied to them.
+   */
+  void DecoupleInactiveCoordinates() {
+    const std::vector<int> inactiveIndices = GetInactiveIndices();
+    const MatX Iai = I_(activeIndices_, inactiveIndices);
+    if (!(Iai.array() != Scalar(0)).any()) {
+      return;
+    }
+    Eigen::LDLT<MatX> Iaa_LDLT(I_(activeIndices_, activeIndices_));
+    Eigen::LDLT<MatX> Iii_LDLT(I_(inactiveIndices, inactiveIndices));
+    TSIF_LOGEIF((Iaa_LDLT.info() != Eigen::Success || Iii_LDLT.info() != Eigen::Success),
+                "Factorization for decoupling the inactive coordinates failed");
+    const MatX IiaIaaInv = Iaa_LDLT.solve(Iai).transpose();
+    I_(activeIndices_, activeIndices_) -= Iai * Iii_LDLT.solve(Iai.transpose());
+    I_(inactiveIndices, inactiveIndices) -= IiaIaaInv * Iai;
+    I_(activeIndices_, inactiveIndices).setZero();
+    I_(inactiveIndices, activeIndices_).setZero();
+  }
+
+  /*! \brief Writes the updated information of the active coordinates back into I_. Inactive
+   *         coordinates keep their own information block, they have been decoupled by BeginUpdateStep.
+   */
+  void ScatterActiveInformation(const MatX& newInf) { I_(activeIndices_, activeIndices_) = newInf; }
+
+  /*! \brief Sets problemColumns_ for every residual from activeIndices_.
+   */
+  template <size_t... Cs>
+  void SetProblemColumns(std::index_sequence<Cs...>) {
+    problemIndex_.assign(State::Dim(), -1);
+    for (size_t k = 0; k < activeIndices_.size(); k++) {
+      problemIndex_[activeIndices_[k]] = k;
+    }
+    (SetProblemColumns<Cs>(), ...);
+  }
+  template <int C>
+  void SetProblemColumns() {
+    typedef typename std::tuple_element<C, ResidualTuple>::type R;
+    ProblemColumns& columns = problemColumns_[C];
+    SetProblemColumns<typename R::Previous>(0, columns.preCols_, columns.pre_);
+    SetProblemColumns<typename R::Current>(R::Previous::Dim(), columns.curCols_, columns.cur_);
+  }
+  template <typename In>
+  void SetProblemColumns(int col0, std::vector<int>& cols, std::vector<int>& indices) const {
+    cols.clear();
+    indices.clear();
+    for (int c = 0; c < In::kN; c++) {
+      for (int k = 0; k < In::kDims[c]; k++) {
+        const int index = problemIndex_[State::Start(In::kIds[c]) + k];
+        if (index >= 0) {
+          cols.push_back(col0 + In::Start(In::kIds[c]) + k);
+          indices.push_back(index);
+        }
+      }
+    }
+  }
+
+  /*! \brief Fetches the measurements at t from the timelines. Only reads the timelines (and not the residuals or the
+   *         state), such that it can run concurrently to the solve of the previous step.
+   */
   template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  int PreProcessResidual(TimePoint t) {
-    std::get<C>(residuals_).isActive_ = std::get<C>(timelines_).HasMeas(t);
+  void StageMeasurements(TimePoint t, TimePoint previous, StagedStep& staged) {
+    auto& timeline = std::get<C>(timelines_);
+    std::get<C>(staged.meas_) = timeline.HasMeas(t) ? timeline.Get(t) : nullptr;
+    StageMeasurements<C + 1>(t, previous, staged);
+  }
+  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
+  void StageMeasurements(TimePoint t, TimePoint previous, StagedStep& staged) {
+    staged.time_ = t;
+    staged.previous_ = previous;
+  }
+
+  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
+  int PreProcessResidual(const StagedStep& staged) {
+    std::get<C>(residuals_).isActive_ = std::get<C>(staged.meas_) != nullptr;
+    std::get<C>(residuals_).isRejected_ = false;
     assert(std::get<C>(residuals_).isActive_ || !std::get<C>(residuals_).isMandatory_);
     if (std::get<C>(residuals_).isActive_) {
-      std::get<C>(residuals_).dt_ = toSec(t - time_);
-      std::get<C>(residuals_).meas_ = std::get<C>(timelines_).Get(t);
+      std::get<C>(residuals_).dt_ = toSec(staged.time_ - staged.previous_);
+      std::get<C>(residuals_).meas_ = std::get<C>(staged.meas_);
     }
-    return PreProcessResidual<C + 1>(t) + std::tuple_element<C, ResidualTuple>::type::Output::Dim();
+    return PreProcessResidual<C + 1>(staged) + std::tuple_element<C, ResidualTuple>::type::Output::Dim();
   }
   template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  int PreProcessResidual(TimePoint /*t*/) {
+  int PreProcessResidual(const StagedStep& /*staged*/) {
     return 0;
   }
 
+  /*! \brief Accumulates the Gram blocks Hpp_, Hpc_, Hcc_ and gradients bp_, bc_ of the whitened residuals and returns the
+   *         used innovation dimension. The residuals are first evaluated independently (EvaluateResidual), in parallel
+   *         on threadPool_ if set, and then added in their fixed order, such that the result does not depend on the
+   *         threading.
+   */
+  int ConstructProblem() {
+    static constexpr std::array<void (Filter::*)(), kN> kEvaluators = MakeEvaluators(std::make_index_sequence<kN>());
+    if (threadPool_ != nullptr && threadPool_->GetNumThreads() > 1) {
+      threadPool_->ParallelFor(kN, [this](int c) { (this->*kEvaluators[c])(); });
+    } else {
+      for (int c = 0; c < kN; c++) {
+        (this->*kEvaluators[c])();
+      }
+    }
+    if (iter_ == 0) {
+      EvaluateInnovations();
+    }
+    return AccumulateProblem(0);
+  }
+  template <size_t... Cs>
+  static constexpr std::array<void (Filter::*)(), kN> MakeEvaluators(std::index_sequence<Cs...>) {
+    return {{&Filter::EvaluateResidual<Cs>...}};
+  }
+
+  /*! \brief Evaluates residual C into its compact Jacobian localJac_, Gram matrix localGram_ and gradient localGrad_.
+   *         Residuals rejected by the gating (see EvaluateInnovations) stay rejected for the rest of the update. While
+   *         being evaluated, the residuals share linearizationCache_ (detached afterwards, such that finite differences
+   *         on perturbed states never see cached values).
+   *         Residuals see compact views of their elements and write an Output::Dim() x (Previous::Dim() + Current::Dim())
+   *         Jacobian. For residuals with a constant Jacobian (ConstantJacobianTrait) and no whitening matrix, the
+   *         Jacobian and its Gram matrix are computed once and only rescaled by the current weight (localJacScale_).
+   *         The IRLS weight of the robust loss enters through localScale_ and localGrad_.
+   */
+  template <int C>
+  void EvaluateResidual() {
+    typedef typename std::tuple_element<C, ResidualTuple>::type R;
+    typedef typename R::Output Output;
+    typedef typename R::Previous Previous;
+    typedef typename R::Current Current;
+    constexpr int kPreDim = Previous::Dim();
+    constexpr int kCurDim = Current::Dim();
+    auto& res = std::get<C>(residuals_);
+    isUsed_[C] = res.isActive_ && !res.isRejected_ && Output::Dim() > 0;
+    if (!isUsed_[C]) {
+      return;
+    }
+    res.cache_ = &linearizationCache_;
+    const typename Previous::CRef pre(state_, CompactLayout());
+    const typename Current::CRef cur(curLinState_, CompactLayout());
+    MatX& J = localJac_[C];
+    MatX& G = localGram_[C];
+    Output ySub;
+    res.EvalRes(ySub, pre, cur);
+    Scalar scale(1);
+    if (ConstantJacobianTrait<R>::value && res.GetWhitening() == nullptr) {
+      if (!isGramConstant_[C]) {
+        J.setZero(Output::Dim(), kPreDim + kCurDim);
+        res.JacPre(J.leftCols(kPreDim), pre, cur);
+        res.JacCur(J.rightCols(kCurDim), pre, cur);
+        G.noalias() = J.transpose() * J;
+        isGramConstant_[C] = true;
+      }
+      const double w = res.GetWeight();
+      ySub.Scale(w);
+      scale = Scalar(w);
+    } else {
+      isGramConstant_[C] = false;
+      J.setZero(Output::Dim(), kPreDim + kCurDim);
+      res.JacPre(J.leftCols(kPreDim), pre, cur);
+      res.JacCur(J.rightCols(kCurDim), pre, cur);
+      res.AddNoise(ySub, J.leftCols(kPreDim), J.rightCols(kCurDim), pre, cur);
+      G.noalias() = J.transpose() * J;
+    }
+    const Scalar robustWeight = Scalar(res.EvalRobustWeight(ySub));
+    Vec<Output::Dim(), Scalar> y;
+    ySub.GetVec(y);
+    localRes_[C] = y;
+    localJacScale_[C] = scale;
+    localGrad_[C].noalias() = (scale * robustWeight) * (J.transpose() * y);
+    localScale_[C] = scale * scale * robustWeight;
+    res.cache_ = nullptr;
+  }
+
+  /*! \brief Gates the evaluated residuals with gateTh_ > 0 on their normalized innovation squared
+   *         y^T * (I + J*P*J^T)^-1 * y, with y and J the whitened residual and Jacobian (i.e. y^T * (R + H*P*H^T)^-1 * y
+   *         in measurement units). It is chi-square distributed with Output::Dim() degrees of freedom. P is the
+   *         covariance given the prior and the residuals which are not gated themselves. Coordinates which these leave
+   *         unconstrained only get a small regularization, such that their residuals are accepted. With
+   *         SetInnovationScoring, the innovation cost of the gated and of the current residuals is added to
+   *         accumulatedCost_ as well (see EvaluateInnovation). Only runs if such a residual is active.
+   *         If the gated residuals only involve the current state, P is the inverse of the Schur complement of the
+   *         previous state, whose D^-1 * Hpc is reused by the solve of the first iteration (gated current residuals do
+   *         not change D and Hpc). Otherwise the joint problem of both states is factorized.
+   */
+  void EvaluateInnovations() { EvaluateInnovations(std::make_index_sequence<kN>()); }
+  template <size_t... Cs>
+  void EvaluateInnovations(std::index_sequence<Cs...>) {
+    if (!((IsGated<Cs>() || IsScored<Cs>()) || ...)) {
+      return;
+    }
+    const bool isReduced = IsReduced();
+    const MatX& I = isReduced ? activeI_ : I_;
+    const MatX& Hpp = isReduced ? activeHpp_ : Hpp_;
+    const MatX& Hpc = isReduced ? activeHpc_ : Hpc_;
+    const MatX& Hcc = isReduced ? activeHcc_ : Hcc_;
+    const int n = I.rows();
+    const Scalar regularization = std::sqrt(Eigen::NumTraits<Scalar>::epsilon());
+    AccumulateProblem(0, true);
+    if ((IsGatedWithPrevious<Cs>() || ...)) {
+      MatX L(2 * n, 2 * n);
+      L << I + Hpp, Hpc, Hpc.transpose(), Hcc;
+      L.diagonal().array() += regularization * std::max(Scalar(1), L.diagonal().maxCoeff());
+      const Eigen::LDLT<MatX> L_LDLT(L);
+      TSIF_LOGEIF((L_LDLT.info() != Eigen::Success), "Factorization for gating failed");
+      (EvaluateInnovation<Cs>(L_LDLT, n), ...);
+    } else {
+      const MatX D = I + Hpp;
+      const Eigen::LDLT<MatX> D_LDLT(D);
+      TSIF_LOGEIF((D_LDLT.info() != Eigen::Success), "Computation of Dinv failed");
+      gatingDinvHpc_ = D_LDLT.solve(Hpc);
+      MatX S = Hcc - Hpc.transpose() * gatingDinvHpc_;
+      S = Scalar(0.5) * (S + S.transpose().eval());
+      S.diagonal().array() += regularization * std::max(Scalar(1), S.diagonal().maxCoeff());
+      const Eigen::LDLT<MatX> S_LDLT(S);
+      TSIF_LOGEIF((S_LDLT.info() != Eigen::Success), "Factorization for gating failed");
+      (EvaluateInnovation<Cs>(S_LDLT, 0), ...);
+      isGatingDinvHpcValid_ = true;
+    }
+    ResetProblem();
+  }
+  template <int C>
+  bool IsGated() const {
+    return isUsed_[C] && std::get<C>(residuals_).gateTh_ > 0;
+  }
+  template <int C>
+  bool IsGatedWithPrevious() const {
+    return IsGated<C>() && !problemColumns_[C].pre_.empty();
+  }
+  /*! \brief Is the innovation of the (not gated) residual C scored, only residuals of the current state are.
+   */
+  template <int C>
+  bool IsScored() const {
+    return isInnovationScored_ && isUsed_[C] && !IsGated<C>() && problemColumns_[C].pre_.empty();
+  }
+  /*! \brief Gates and scores residual C with the factorization L_LDLT of the inverse of P, in which the current state
+   *         starts at curStart. The innovation covariance is S = I + J*P*J^T and its cost y^T * S^-1 * y + log(det(S)),
+   *         a block rejected by the gating costs gateTh_. P of a scored residual which is not gated contains the
+   *         residual itself (with its robust weight r), its S follows from M = J*P*J^T as
+   *         I + M + r * M * (I - r*M)^-1 * M.
+   */
+  template <int C>
+  void EvaluateInnovation(const Eigen::LDLT<MatX>& L_LDLT, int curStart) {
+    const bool isGated = IsGated<C>();
+    if (!isGated && !IsScored<C>()) {
+      return;
+    }
+    const ProblemColumns& columns = problemColumns_[C];
+    std::vector<int> cols(columns.preCols_), indices(columns.pre_);
+    cols.insert(cols.end(), columns.curCols_.begin(), columns.curCols_.end());
+    for (int index : columns.cur_) {
+      indices.push_back(curStart + index);
+    }
+    MatX E = MatX::Zero(L_LDLT.rows(), indices.size());
+    for (size_t j = 0; j < indices.size(); j++) {
+      E(indices[j], j) = Scalar(1);
+    }
+    const MatX P = L_LDLT.solve(E)(indices, Eigen::all);
+    const MatX J = localJacScale_[C] * localJac_[C](Eigen::all, cols);
+    const MatX M = J * P * J.transpose();
+    MatX S = M;
+    if (!isGated) {
+      const Scalar robustWeight = localScale_[C] / (localJacScale_[C] * localJacScale_[C]);
+      const MatX Mr = robustWeight * M;
+      S += Mr * (MatX::Identity(M.rows(), M.rows()) - Mr).ldlt().solve(M);
+    }
+    S.diagonal().array() += Scalar(1);
+    const Eigen::LDLT<MatX> S_LDLT(S);
+    const VecX& y = localRes_[C];
+    const double nis = double(y.dot(S_LDLT.solve(y)));
+    auto& res = std::get<C>(residuals_);
+    if (isGated) {
+      isUsed_[C] = res.Gate(nis);
+    }
+    if (isInnovationScored_) {
+      accumulatedCost_ += isUsed_[C] ? nis + double(S_LDLT.vectorD().array().log().sum()) : res.gateTh_;
+    }
+  }
+  /*! \brief Adds the evaluated residuals in order. Residuals without previous elements thus only add to Hcc_ and bc_
+   *         and do not enter the marginalization of the previous state. A reduced problem only receives the active
+   *         columns (see problemColumns_). With isGatedSkipped the residuals which are gated (see EvaluateInnovations)
+   *         are left out.
+   */
   template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
-  void ConstructProblem(int start) {
-    typedef typename std::tuple_element<C, ResidualTuple>::type::Output Output;
-    if (std::get<C>(residuals_).isActive_ && Output::Dim() > 0) {
-      Output ySub;
-      std::get<C>(residuals_).EvalRes(ySub, state_, curLinState_);
-      std::get<C>(residuals_).JacPre(JacPre_.block<Output::Dim(), State::Dim()>(start, 0), state_, curLinState_);
-      std::get<C>(residuals_).JacCur(JacCur_.block<Output::Dim(), State::Dim()>(start, 0), state_, curLinState_);
-      std::get<C>(residuals_)
-          .AddNoise(ySub, JacPre_.block<Output::Dim(), State::Dim()>(start, 0), JacCur_.block<Output::Dim(), State::Dim()>(start, 0),
-                    state_, curLinState_);
-      ySub.GetVec(y_.block<Output::Dim(), 1>(start, 0));
-    }
-    ConstructProblem<C + 1>(start + Output::Dim() * std::get<C>(residuals_).isActive_);
+  int AccumulateProblem(int innDim, bool isGatedSkipped = false) {
+    typedef typename std::tuple_element<C, ResidualTuple>::type R;
+    typedef typename R::Previous Previous;
+    typedef typename R::Current Current;
+    constexpr int kPreDim = Previous::Dim();
+    const bool isAdded = isUsed_[C] && !(isGatedSkipped && IsGated<C>());
+    if (isAdded && IsReduced()) {
+      const MatX& G = localGram_[C];
+      const Scalar scale = localScale_[C];
+      const ProblemColumns& columns = problemColumns_[C];
+      activeHpp_(columns.pre_, columns.pre_) += scale * G(columns.preCols_, columns.preCols_);
+      activeHpc_(columns.pre_, columns.cur_) += scale * G(columns.preCols_, columns.curCols_);
+      activeHcc_(columns.cur_, columns.cur_) += scale * G(columns.curCols_, columns.curCols_);
+      activeBp_(columns.pre_) += localGrad_[C](columns.preCols_);
+      activeBc_(columns.cur_) += localGrad_[C](columns.curCols_);
+    } else if (isAdded) {
+      const MatX& G = localGram_[C];
+      AddGram<Previous, Previous>(G, 0, 0, localScale_[C], Hpp_, std::make_index_sequence<Previous::kN>());
+      AddGram<Previous, Current>(G, 0, kPreDim, localScale_[C], Hpc_, std::make_index_sequence<Previous::kN>());
+      AddGram<Current, Current>(G, kPreDim, kPreDim, localScale_[C], Hcc_, std::make_index_sequence<Current::kN>());
+      AddGradient<Previous>(localGrad_[C], 0, bp_, std::make_index_sequence<Previous::kN>());
+      AddGradient<Current>(localGrad_[C], kPreDim, bc_, std::make_index_sequence<Current::kN>());
+    }
+    return AccumulateProblem<C + 1>(innDim + R::Output::Dim() * isAdded, isGatedSkipped);
   }
   template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
-  void ConstructProblem(int /*start*/) {}
+  int AccumulateProblem(int innDim, bool /*isGatedSkipped*/ = false) {
+    return innDim;
+  }
+
+  /*! \brief Adds the scaled blocks of the compact Gram matrix G (elements InA x InB, starting at row0/col0) to H, at the
+   *         compile-time offsets of the elements in the state.
+   */
+  template <typename InA, typename InB, size_t... As>
+  static void AddGram(const MatX& G, [[maybe_unused]] int row0, [[maybe_unused]] int col0, [[maybe_unused]] Scalar scale,
+                      MatX& H, std::index_sequence<As...>) {
+    (AddGramRow<InA, InB, As>(G, row0, col0, scale, H, std::make_index_sequence<InB::kN>()), ...);
+  }
+  template <typename InA, typename InB, size_t A, size_t... Bs>
+  static void AddGramRow(const MatX& G, [[maybe_unused]] int row0, [[maybe_unused]] int col0, [[maybe_unused]] Scalar scale,
+                         MatX& H, std::index_sequence<Bs...>) {
+    ((H.template block<InA::kDims[A], InB::kDims[Bs]>(State::Start(InA::kIds[A]), State::Start(InB::kIds[Bs])) +=
+          scale * G.template block<InA::kDims[A], InB::kDims[Bs]>(row0 + InA::Start(InA::kIds[A]),
+                                                                   col0 + InB::Start(InB::kIds[Bs]))),
+     ...);
+  }
+  template <typename In, size_t... Cs>
+  static void AddGradient(const VecX& g, [[maybe_unused]] int row0, VecX& b, std::index_sequence<Cs...>) {
+    ((b.template segment<In::kDims[Cs]>(State::Start(In::kIds[Cs])) +=
+          g.template segment<In::kDims[Cs]>(row0 + In::Start(In::kIds[Cs]))),
+     ...);
+  }
 
   template <int N = 0, typename std::enable_if<(N < kN)>::type* = nullptr>
   int JacTestAll(double th, double d, const State& pre, const State& cur) {
@@ -280,37 +900,30 @@ class Filter {
     return 0;
   }
 
+  TimePoint GetTime() const { return time_; }
   const State& GetState() const { return state_; }
   State& GetState() { return state_; }
 
-  template <int N = 0, int C = 0, bool B = false, typename std::enable_if<(N < kN)>::type* = nullptr>
-  std::string PrintConnectivityRes() {
-    std::ostringstream out;
-    if (!B) {
-      if (std::tuple_element<N, ResidualTuple>::type::Previous::template HasId<State::template GetId<C>()>()) {
-        out << "--" << " ";
-      } else {
-        out << "   ";
-      }
-      if (C == State::kN - 1) {
-        if (N < 10) out << " ";
-        out << N << " ";
-      }
-    } else {
-      if (std::tuple_element<N, ResidualTuple>::type::Current::template HasId<State::template GetId<C>()>()) {
-        out << "--" << " ";
-      } else {
-        out << "   ";
-      }
-      if (C == State::kN - 1) out << std::endl;
+  template <int N>
+  void PrintConnectivityRes(std::ostringstream& out) {
+    typedef typename std::tuple_element<N, ResidualTuple>::type R;
+    for (int c = 0; c < State::kN; c++) {
+      out << (R::Previous::FindC(State::kIds[c]) >= 0 ? "-- " : "   ");
     }
-    out << PrintConnectivityRes < N + ((C == State::kN - 1) & B), (C == State::kN - 1) ? 0 : C + 1, ((C == State::kN - 1) ? !B : B) > ();
-    return out.str();
+    if (N < 10) out << " ";
+    out << N << " ";
+    for (int c = 0; c < State::kN; c++) {
+      out << (R::Current::FindC(State::kIds[c]) >= 0 ? "-- " : "   ");
+    }
+    out << std::endl;
   }
-  template <int N = 0, int C = 0, bool B = false, typename std::enable_if<(N >= kN)>::type* = nullptr>
-  std::string PrintConnectivityRes() {
-    return "";
+  template <size_t... Ns>
+  std::string PrintConnectivityRes(std::index_sequence<Ns...>) {
+    std::ostringstream out;
+    (PrintConnectivityRes<Ns>(out), ...);
+    return out.str();
   }
+  std::string PrintConnectivityRes() { return PrintConnectivityRes(std::make_index_sequence<kN>()); }
 
   std::string PrintConnectivity() {
     std::ostringstream out;
@@ -338,6 +951,250 @@ class Filter {
 
   MatX GetInformation() const { return I_; }
 
+  /*! \brief Copies the latest published snapshot. Lock-free and never blocks Update(), safe to call from any
+   *         thread. Returns false if no update step has been carried out yet.
+   */
+  bool GetSnapshot(Snapshot& snapshot) const { return snapshots_.Read(snapshot); }
+
+  /*! \brief Adds the coordinates [start, start+dim) to the joint covariance available from the snapshots.
+   */
+  void AddSnapshotCovarianceBlock(int start, int dim) {
+    assert(start >= 0 && dim >= 0 && start + dim <= State::Dim());
+    for (int i = start; i < start + dim; i++) {
+      snapshotIndices_.push_back(i);
+    }
+  }
+  void ClearSnapshotCovarianceBlocks() { snapshotIndices_.clear(); }
+
+  /*! \brief Predicts the state at t by propagating the committed state_ through the buffered measurements of the
+   *         prediction residuals (see SetPredictionResidual) which Update() has not processed yet. At every measurement
+   *         time and at t, the current state is solved from the prediction residuals with the previous state held fixed.
+   *         Beyond the newest measurement the last one is held. The estimate of the filter is not modified. The
+   *         propagation up to the last measurement time is cached, such that repeated queries only process new
+   *         measurements. Has to be called from the thread which calls AddMeas and Update.
+   */
+  State PredictState(TimePoint t) {
+    if (t <= time_) {
+      TSIF_LOGWIF(t < time_, "Warning: predicting state in past!");
+      return state_;
+    }
+    if (!predictionResiduals_) {
+      predictionResiduals_ = std::make_shared<ResidualTuple>(residuals_);
+    }
+    if (!isPredictionValid_ || t < predictionTime_) {
+      predictionState_ = state_;
+      predictionTime_ = time_;
+      isPredictionValid_ = true;
+    }
+    std::set<TimePoint> times;
+    GetPredictionTimes(times, predictionTime_, t);
+    for (const auto& s : times) {
+      PredictStep(predictionTime_, s, predictionState_);
+      predictionTime_ = s;
+    }
+    State state = predictionState_;
+    if (t > predictionTime_) {
+      PredictStep(predictionTime_, t, state);
+    }
+    return state;
+  }
+
+  /*! \brief Selects whether residual C is used by PredictState. Defaults to the residuals with previous elements, update
+   *         residuals which act as prediction (e.g. a gyroscope measuring the rotational rate) can be added.
+   */
+  template <int C>
+  void SetPredictionResidual(bool isPrediction) {
+    isPredictionResidual_[C] = isPrediction;
+    isPredictionValid_ = false;
+  }
+
+  /*! \brief Measurement times of the prediction residuals in (start, end].
+   */
+  template <int C = 0, typename std::enable_if<(C < kN)>::type* = nullptr>
+  void GetPredictionTimes(std::set<TimePoint>& times, TimePoint start, TimePoint end) const {
+    if (isPredictionResidual_[C]) {
+      std::get<C>(timelines_).GetAllInRange(times, start, end);
+    }
+    GetPredictionTimes<C + 1>(times, start, end);
+  }
+  template <int C = 0, typename std::enable_if<(C >= kN)>::type* = nullptr>
+  void GetPredictionTimes(std::set<TimePoint>& /*times*/, TimePoint /*start*/, TimePoint /*end*/) const {}
+
+  /*! \brief Propagates state from t0 to t1 by Gauss-Newton iterations on the current state of the prediction residuals,
+   *         starting at the previous state. Coordinates without a prediction residual are kept.
+   */
+  void PredictStep(TimePoint t0, TimePoint t1, State& state) {
+    const State pre = state;
+    for (int iter = 0; iter < std::max(max_iter_, 1); iter++) {
+      predictionH_.setZero(State::Dim(), State::Dim());
+      predictionB_.setZero(State::Dim());
+      AddPredictionResiduals(t1, toSec(t1 - t0), pre, state, std::make_index_sequence<kN>());
+      for (int i = 0; i < State::Dim(); i++) {
+        if (predictionH_(i, i) == Scalar(0)) {
+          predictionH_(i, i) = Scalar(1);
+        }
+      }
+      const VecX dx = -predictionH_.ldlt().solve(predictionB_);
+      State newState;
+      state.Boxplus(dx, newState);
+      state = newState;
+    }
+  }
+  template <size_t... Cs>
+  void AddPredictionResiduals(TimePoint t, double dt, const State& pre, const State& cur, std::index_sequence<Cs...>) {
+    (AddPredictionResidual<Cs>(t, dt, pre, cur), ...);
+  }
+
+  /*! \brief Adds the Gram matrix and gradient of the whitened current Jacobian of residual C to predictionH_ and
+   *         predictionB_. The residual is whitened by AddNoise like in EvaluateResidual. It is evaluated on its scratch
+   *         copy in predictionResiduals_, which takes over the parameters of the filter's residual and gets the
+   *         measurement and dt_ of the prediction, such that the residuals of the filter are not modified.
+   */
+  template <int C>
+  void AddPredictionResidual(TimePoint t, double dt, const State& pre, const State& cur) {
+    typedef typename std::tuple_element<C, ResidualTuple>::type R;
+    typedef typename R::Output Output;
+    typedef typename R::Previous Previous;
+    typedef typename R::Current Current;
+    if (!isPredictionResidual_[C] || Output::Dim() == 0 || Current::kN == 0) {
+      return;
+    }
+    auto meas = std::get<C>(timelines_).GetCovering(t);
+    if (meas == nullptr) {
+      return;
+    }
+    R& res = std::get<C>(*predictionResiduals_);
+    res.CopyParameters(std::get<C>(residuals_));
+    res.dt_ = dt;
+    res.meas_ = meas;
+    res.cache_ = nullptr;
+    const typename Previous::CRef preRef(pre, CompactLayout());
+    const typename Current::CRef curRef(cur, CompactLayout());
+    Output ySub;
+    res.EvalRes(ySub, preRef, curRef);
+    MatX J_pre = MatX::Zero(Output::Dim(), Previous::Dim());
+    MatX J = MatX::Zero(Output::Dim(), Current::Dim());
+    res.JacCur(J, preRef, curRef);
+    res.AddNoise(ySub, J_pre, J, preRef, curRef);
+    Vec<Output::Dim(), Scalar> y;
+    ySub.GetVec(y);
+    const MatX G = J.transpose() * J;
+    const VecX g = J.transpose() * y;
+    AddGram<Current, Current>(G, 0, 0, Scalar(1), predictionH_, std::make_index_sequence<Current::kN>());
+    AddGradient<Current>(g, 0, predictionB_, std::make_index_sequence<Current::kN>());
+  }
+
+  /*! \brief Number of updates in which each residual has been rejected by the innovation gating.
+   */
+  std::array<int, kN> GetRejectionCounts() const { return GetRejectionCounts(std::make_index_sequence<kN>()); }
+  template <size_t... Ns>
+  std::array<int, kN> GetRejectionCounts(std::index_sequence<Ns...>) const {
+    return {std::get<Ns>(residuals_).rejectionCount_...};
+  }
+
+  /*! \brief Sum of the innovation costs y^T * S^-1 * y + log(det(S)) of the scored residual blocks of all update steps,
+   *         i.e. twice the negative log-likelihood of their measurements up to a constant (see EvaluateInnovation).
+   *         Blocks rejected by the gating add their threshold gateTh_ instead. Used to score hypotheses.
+   */
+  double GetAccumulatedCost() const { return accumulatedCost_; }
+  /*! \brief Accumulates the innovation cost (GetAccumulatedCost) of the gated residuals and of the residuals which only
+   *         involve the current state. Costs an additional factorization per update step if no residual is gated.
+   */
+  void SetInnovationScoring(bool enable) { isInnovationScored_ = enable; }
+
+  /*! \brief Takes over the estimate and the timelines of a clone of this filter (e.g. the winning hypothesis).
+   */
+  void CommitHypothesis(Filter& winner) {
+    timelines_ = winner.timelines_;
+    CommitRejectionCounts(winner, std::make_index_sequence<kN>());
+    is_initialized_ = winner.is_initialized_;
+    startTime_ = winner.startTime_;
+    time_ = winner.time_;
+    state_ = winner.state_;
+    curLinState_ = winner.curLinState_;
+    I_.swap(winner.I_);
+    accumulatedCost_ = winner.accumulatedCost_;
+    isPredictionValid_ = false;
+    PublishSnapshot();
+  }
+  template <size_t... Cs>
+  void CommitRejectionCounts(const Filter& winner, std::index_sequence<Cs...>) {
+    ((std::get<Cs>(residuals_).rejectionCount_ = std::get<Cs>(winner.residuals_).rejectionCount_), ...);
+  }
+
+  /*! \brief Marginalizes the state block [start, start+dim) out of the information matrix.
+   *         The Schur complement is only applied to the coordinates coupled to the block.
+   *         Afterwards the block is decoupled and holds the default (identity) prior.
+   */
+  void MarginalizeBlock(int start, int dim) {
+    assert(start >= 0 && dim >= 0 && start + dim <= State::Dim());
+    std::vector<int> block, coupled;
+    for (int i = 0; i < State::Dim(); i++) {
+      if (i >= start && i < start + dim) {
+        block.push_back(i);
+      } else if ((I_.block(i, start, 1, dim).array() != Scalar(0)).any()) {
+        coupled.push_back(i);
+      }
+    }
+    if (!coupled.empty()) {
+      const MatX Icb = I_(coupled, block);
+      Eigen::LDLT<MatX> Ibb_LDLT(I_.block(start, start, dim, dim));
+      TSIF_LOGEIF((Ibb_LDLT.info() != Eigen::Success), "Factorization of marginalized block failed");
+      I_(coupled, coupled) -= Icb * Ibb_LDLT.solve(Icb.transpose());
+      I_(coupled, block).setZero();
+      I_(block, coupled).setZero();
+    }
+    I_.block(start, start, dim, dim).setIdentity();
+  }
+
+  /*! \brief Marginalizes the state block [start, start+dim) and re-inserts it with the given prior information.
+   */
+  void ResetBlock(int start, int dim, const MatX& prior) {
+    assert(prior.rows() == dim && prior.cols() == dim);
+    MarginalizeBlock(start, dim);
+    I_.block(start, start, dim, dim) = prior;
+  }
+
+  /*! \brief Marginalizes a slot of the array element I (e.g. a lost landmark) and deactivates it.
+   */
+  template <int I>
+  void MarginalizeSlot(int slot) {
+    const int dim = ElementTraits<typename StateElementType<I>::value_type>::kDim;
+    MarginalizeBlock(state_.Start(I) + slot * dim, dim);
+    SetSlotActive(state_.template Get<I>(), slot, false);
+  }
+
+  /*! \brief Re-initializes a slot of the array element I with a value and prior information and activates it.
+   */
+  template <int I>
+  void ResetSlot(int slot, const typename StateElementType<I>::value_type& value, const MatX& prior) {
+    const int dim = ElementTraits<typename StateElementType<I>::value_type>::kDim;
+    ResetBlock(state_.Start(I) + slot * dim, dim, prior);
+    state_.template Get<I>()[slot] = value;
+    SetSlotActive(state_.template Get<I>(), slot, true);
+  }
+
+  /*! \brief Evaluates the residuals of each update in parallel on the pool (serially if nullptr). The update does not
+   *         depend on the threading. The pool may be shared between filters.
+   */
+  void SetThreadPool(std::shared_ptr<ThreadPool> threadPool) { threadPool_ = threadPool; }
+
+  /*! \brief Overlaps the staging of the measurements of the next update step with the solve of the current one on a
+   *         background thread (see RunUpdateSteps). PreProcess and PostProcess must then not access the timelines.
+   */
+  void SetPipelining(bool enable) {
+    isPipelining_ = enable;
+    if (!enable) {
+      stagingWorker_ = nullptr;
+    }
+  }
+  const PipelineStats& GetPipelineStats() const { return pipelineStats_; }
+  void ResetPipelineStats() { pipelineStats_ = PipelineStats(); }
+
+  /*! \brief Minimal (active) state dimension from which the dense update kernels run on the thread pool as well.
+   */
+  void SetParallelDenseThreshold(int dim) { parallelDenseDim_ = dim; }
+
   void Uninitialize() { is_initialized_ = false; }
 
   bool IsInitialized() const { return is_initialized_; }
@@ -366,9 +1223,49 @@ class Filter {
   State state_;
   State curLinState_;
   MatX I_;
-  VecX y_;
-  MatX JacPre_;
-  MatX JacCur_;
+  MatX Hpp_;  // Gram blocks of the whitened Jacobians: JacPre^T * JacPre, JacPre^T * JacCur and JacCur^T * JacCur
+  MatX Hpc_;
+  MatX Hcc_;
+  VecX bp_;  // Gradients JacPre^T * y and JacCur^T * y
+  VecX bc_;
+  std::vector<int> activeIndices_;
+  std::vector<int> problemIndex_;  // Position of every state coordinate in the problem (-1 if inactive)
+  std::array<ProblemColumns, kN> problemColumns_;
+  MatX activeI_;
+  MatX activeHpp_;
+  MatX activeHpc_;
+  MatX activeHcc_;
+  VecX activeBp_;
+  VecX activeBc_;
+  MatX updateInf_;  // Information and increment of the current iteration (active coordinates)
+  VecX updateDx_;
+  std::array<MatX, kN> localJac_;       // Compact Jacobians of the residuals (Output::Dim() x (Previous + Current)::Dim())
+  std::array<MatX, kN> localGram_;      // Gram matrices of the compact Jacobians
+  std::array<VecX, kN> localGrad_;      // Weighted gradients of the compact Jacobians
+  std::array<VecX, kN> localRes_;       // Whitened residuals (without the robust weight)
+  std::array<Scalar, kN> localJacScale_;  // Factor from localJac_ to the whitened Jacobian
+  std::array<Scalar, kN> localScale_;   // Weight of the Gram matrices
+  double accumulatedCost_;              // Innovation cost of all update steps (see SetInnovationScoring)
+  bool isInnovationScored_;             // Is the innovation cost accumulated
+  std::array<bool, kN> isGramConstant_;  // Do localJac_ and localGram_ hold the unweighted constant Jacobian
+  std::array<bool, kN> isUsed_;          // Is the residual part of the current problem
+  MatX gatingDinvHpc_;                   // D^-1 * Hpc of the gating, valid for the solve if isGatingDinvHpcValid_
+  bool isGatingDinvHpcValid_;
+  std::shared_ptr<ThreadPool> threadPool_;  // Evaluates the residuals in parallel if set
+  int parallelDenseDim_;                    // Crossover of the parallel dense kernels
+  bool isPipelining_;                                // Is the staging overlapped with the solve (see SetPipelining)
+  std::shared_ptr<BackgroundWorker> stagingWorker_;  // Stages the next update step, owned by this filter
+  PipelineStats pipelineStats_;
+  LinearizationCache<Scalar> linearizationCache_;  // Quantities shared across the residuals, valid for one ConstructProblem
+  SnapshotBuffer<Snapshot> snapshots_;             // Published estimates for concurrent readers
+  std::vector<int> snapshotIndices_;               // Coordinates of the published covariance
+  std::array<bool, kN> isPredictionResidual_;      // Is the residual used by PredictState
+  bool isPredictionValid_;                         // Does predictionState_ hold the propagation of state_
+  TimePoint predictionTime_;                       // Time of predictionState_ (last propagated measurement time)
+  State predictionState_;
+  std::shared_ptr<ResidualTuple> predictionResiduals_;  // Scratch residuals of PredictState, not copied with the filter
+  MatX predictionH_;  // Gram matrix and gradient of a prediction step
+  VecX predictionB_;
   int max_iter_;
   int iter_;
   double weightedDelta_;
@@ -0,0 +1,264 @@
+#ifndef TSIF_FILTER_SCHEDULER_H_
+#define TSIF_FILTER_SCHEDULER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "tsif/utils/thread_pool.h"
+#include "tsif/utils/timing.h"
+
+namespace tsif {
+
+/*! \brief Filter Scheduler
+ *         Runs the Update() of many registered filter instances as tasks on one shared ThreadPool instead of one thread
+ *         per instance. Measurements are added through the Handle returned by Register, which marks the instance ready
+ *         once Update() has work to do (Filter::HasPendingUpdate). After Start(), every instance which becomes ready is
+ *         submitted as its own pool task (ThreadPool::Submit), which resubmits itself if new measurements arrived during
+ *         the update. Instances thus progress independently, a slow filter only occupies one worker. Without Start(),
+ *         RunOnce updates all ready instances in a lock-step round. Each instance is only accessed under its own mutex,
+ *         such that producers of different instances do not contend.
+ */
+class FilterScheduler {
+ public:
+  /*! \brief Per-instance statistics. The latency is the wall time from the instance becoming ready to the end of its
+   *         update, i.e. waiting for the dispatch plus Update() itself.
+   */
+  struct InstanceStats {
+    int updates_ = 0;
+    double totalLatency_ = 0;
+    double maxLatency_ = 0;
+    double totalUpdateTime_ = 0;
+    double GetMeanLatency() const { return updates_ > 0 ? totalLatency_ / updates_ : 0; }
+  };
+
+ private:
+  struct Instance {
+    std::mutex mutex_;
+    std::function<void()> update_;
+    std::function<bool()> hasPendingUpdate_;
+    bool isReady_ = false;
+    bool isScheduled_ = false;  // Is a task of the instance submitted or running
+    TimePoint readySince_;
+    InstanceStats stats_;
+  };
+
+ public:
+  /*! \brief Access to a registered filter. AddMeas and Access lock the instance, the filter must not be used directly
+   *         while the scheduler runs.
+   */
+  template <typename FilterType>
+  class Handle {
+   public:
+    Handle() : scheduler_(nullptr), instance_(nullptr), filter_(nullptr) {}
+    template <int N, typename Measurement>
+    void AddMeas(TimePoint t, std::shared_ptr<const Measurement> m) {
+      bool isSubmitted;
+      {
+        std::lock_guard<std::mutex> lock(instance_->mutex_);
+        filter_->template AddMeas<N>(t, m);
+        isSubmitted = scheduler_->MarkIfReady(*instance_);
+      }
+      if (isSubmitted) {
+        scheduler_->Submit(*instance_);
+      }
+    }
+    /*! \brief Calls f(filter) under the instance lock (e.g. to read the state or change the configuration).
+     */
+    template <typename F>
+    void Access(F&& f) {
+      bool isSubmitted;
+      {
+        std::lock_guard<std::mutex> lock(instance_->mutex_);
+        f(*filter_);
+        isSubmitted = scheduler_->MarkIfReady(*instance_);
+      }
+      if (isSubmitted) {
+        scheduler_->Submit(*instance_);
+      }
+    }
+
+   private:
+    friend class FilterScheduler;
+    Handle(FilterScheduler* scheduler, Instance* instance, FilterType* filter)
+        : scheduler_(scheduler), instance_(instance), filter_(filter) {}
+    FilterScheduler* scheduler_;
+    Instance* instance_;
+    FilterType* filter_;
+  };
+
+  explicit FilterScheduler(std::shared_ptr<ThreadPool> pool) : pool_(pool) {
+    isRunning_ = false;
+    inFlight_ = 0;
+  }
+  ~FilterScheduler() { Stop(); }
+  FilterScheduler(const FilterScheduler&) = delete;
+  FilterScheduler& operator=(const FilterScheduler&) = delete;
+
+  /*! \brief Registers a filter which has to outlive the scheduler. The pool may also be passed to the filters
+   *         (SetThreadPool), their nested parallel loops then run serially within the scheduled task.
+   */
+  template <typename FilterType>
+  Handle<FilterType> Register(FilterType* filter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    instances_.emplace_back(new Instance());
+    Instance* instance = instances_.back().get();
+    instance->update_ = [filter]() { filter->Update(); };
+    instance->hasPendingUpdate_ = [filter]() { return filter->HasPendingUpdate(); };
+    return Handle<FilterType>(this, instance, filter);
+  }
+
+  /*! \brief Updates all currently ready instances on the pool in one lock-step round (the call returns once the slowest
+   *         instance is done) and returns their number. Must not be called between Start() and Stop().
+   */
+  int RunOnce() {
+    std::vector<std::pair<TimePoint, Instance*>> ready;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& instance : instances_) {
+        std::lock_guard<std::mutex> instanceLock(instance->mutex_);
+        if (instance->isReady_) {
+          ready.emplace_back(instance->readySince_, instance.get());
+        }
+      }
+    }
+    std::sort(ready.begin(), ready.end());
+    pool_->ParallelFor(ready.size(), [this, &ready](int i) {
+      std::lock_guard<std::mutex> lock(ready[i].second->mutex_);
+      RunInstance(*ready[i].second);
+    });
+    return ready.size();
+  }
+
+  /*! \brief Submits every instance as a pool task whenever it becomes ready, until Stop().
+   */
+  void Start() {
+    std::vector<Instance*> ready;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (isRunning_) {
+        return;
+      }
+      isRunning_ = true;
+      for (const auto& instance : instances_) {
+        std::lock_guard<std::mutex> instanceLock(instance->mutex_);
+        if (MarkIfReady(*instance)) {
+          ready.push_back(instance.get());
+        }
+      }
+    }
+    for (Instance* instance : ready) {
+      Submit(*instance);
+    }
+  }
+  /*! \brief Stops submitting instances and waits for the submitted tasks. Instances which are still ready can be
+   *         updated by RunOnce.
+   */
+  void Stop() {
+    isRunning_ = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& instance : instances_) {  // Producers which already decided to submit have counted their task
+        std::lock_guard<std::mutex> instanceLock(instance->mutex_);
+      }
+    }
+    std::unique_lock<std::mutex> lock(doneMutex_);
+    doneCv_.wait(lock, [this]() { return inFlight_ == 0; });
+  }
+
+  int GetNumInstances() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return instances_.size();
+  }
+  InstanceStats GetStats(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> instanceLock(instances_[id]->mutex_);
+    return instances_[id]->stats_;
+  }
+
+  /*! \brief Jain's fairness index of the mean latencies of the updated instances, 1 if all instances wait equally long
+   *         and 1/n if a single one accounts for all of the latency.
+   */
+  double GetFairnessIndex() const {
+    double sum = 0;
+    double sumSquares = 0;
+    int n = 0;
+    for (int id = 0; id < GetNumInstances(); id++) {
+      const InstanceStats stats = GetStats(id);
+      if (stats.updates_ > 0) {
+        sum += stats.GetMeanLatency();
+        sumSquares += stats.GetMeanLatency() * stats.GetMeanLatency();
+        n++;
+      }
+    }
+    return sumSquares > 0 ? sum * sum / (n * sumSquares) : 1;
+  }
+
+ private:
+  // Called with the instance locked, returns true (and counts the task) if the instance has to be submitted
+  bool MarkIfReady(Instance& instance) {
+    if (!instance.isReady_ && instance.hasPendingUpdate_()) {
+      instance.isReady_ = true;
+      instance.readySince_ = Clock::now();
+    }
+    if (instance.isReady_ && !instance.isScheduled_ && isRunning_) {
+      instance.isScheduled_ = true;
+      inFlight_++;
+      return true;
+    }
+    return false;
+  }
+  // Called without the instance lock (the task may run right away on the calling thread)
+  void Submit(Instance& instance) {
+    pool_->Submit([this, &instance]() { RunTask(instance); });
+  }
+  void RunTask(Instance& instance) {
+    bool isResubmitted;
+    {
+      std::lock_guard<std::mutex> lock(instance.mutex_);
+      RunInstance(instance);
+      instance.isScheduled_ = false;
+      isResubmitted = MarkIfReady(instance);
+    }
+    if (isResubmitted) {
+      Submit(instance);
+    }
+    std::lock_guard<std::mutex> lock(doneMutex_);
+    if (--inFlight_ == 0) {
+      doneCv_.notify_all();
+    }
+  }
+  // Called with the instance locked
+  void RunInstance(Instance& instance) {
+    Timer timer;
+    instance.update_();
+    const TimePoint now = Clock::now();
+    const double latency = toSec(now - instance.readySince_);
+    instance.stats_.updates_++;
+    instance.stats_.totalLatency_ += latency;
+    instance.stats_.maxLatency_ = std::max(instance.stats_.maxLatency_, latency);
+    instance.stats_.totalUpdateTime_ += timer.GetFull();
+    instance.isReady_ = false;
+    if (instance.hasPendingUpdate_()) {  // Measurements which became processable in the meantime
+      instance.isReady_ = true;
+      instance.readySince_ = now;
+    }
+  }
+
+  std::shared_ptr<ThreadPool> pool_;
+  mutable std::mutex mutex_;  // Guards instances_ (taken before the instance mutexes)
+  std::vector<std::unique_ptr<Instance>> instances_;
+  std::atomic<bool> isRunning_;
+  std::mutex doneMutex_;  // Guards the notification of doneCv_ (never held while taking another mutex)
+  std::condition_variable doneCv_;
+  std::atomic<int> inFlight_;  // Number of submitted tasks which have not finished
+};
+
+}  // namespace tsif
+
+#endif  // TSIF_FILTER_SCHEDULER_H_
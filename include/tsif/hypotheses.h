@@ -0,0 +1,65 @@
+#ifndef TSIF_HYPOTHESES_H_
+#define TSIF_HYPOTHESES_H_
+
+#include <memory>
+#include <vector>
+
+#include "tsif/utils/thread_pool.h"
+
+namespace tsif {
+
+/*! \brief Evaluates alternative updates of a filter (e.g. data associations or outlier hypotheses) in parallel and
+ *         commits the best one. Every hypothesis h is applied as h(clone) to its own clone of base (cheap, the
+ *         timelines are shared copy-on-write), typically adding its measurements and calling Update(). The clones
+ *         accumulate their innovation cost (see Filter::SetInnovationScoring), are scored by score(base, clone) and
+ *         base takes over the estimate of the highest score (the first one on ties). Returns the index of the winner
+ *         and optionally all scores.
+ */
+template <typename FilterType, typename Hypothesis, typename Score>
+int EvaluateHypotheses(FilterType& base, const std::vector<Hypothesis>& hypotheses, ThreadPool& pool, Score score,
+                       std::vector<double>* scores = nullptr) {
+  const int n = hypotheses.size();
+  if (n == 0) {
+    return -1;
+  }
+  std::vector<std::unique_ptr<FilterType>> clones(n);
+  std::vector<double> values(n);
+  pool.ParallelFor(n, [&](int i) {
+    clones[i].reset(new FilterType(base));
+    clones[i]->SetInnovationScoring(true);
+    hypotheses[i](*clones[i]);
+    values[i] = score(static_cast<const FilterType&>(base), static_cast<const FilterType&>(*clones[i]));
+  });
+  int winner = 0;
+  for (int i = 1; i < n; i++) {
+    if (values[i] > values[winner]) {
+      winner = i;
+    }
+  }
+  base.CommitHypothesis(*clones[winner]);
+  if (scores != nullptr) {
+    *scores = values;
+  }
+  return winner;
+}
+
+/*! \brief Scores the hypotheses by the log-likelihood of their innovations, -0.5 * the innovation cost
+ *         y^T * S^-1 * y + log(det(S)) added since the clone (see Filter::GetAccumulatedCost). Blocks rejected by the
+ *         gating cost their gate threshold, such that gating a wrong association does not make it win. Suited for
+ *         hypotheses with innovations of equal dimension (e.g. data association), others should pass a score
+ *         accounting for the differing dimensions.
+ */
+template <typename FilterType, typename Hypothesis>
+int EvaluateHypotheses(FilterType& base, const std::vector<Hypothesis>& hypotheses, ThreadPool& pool,
+                       std::vector<double>* scores = nullptr) {
+  return EvaluateHypotheses(
+      base, hypotheses, pool,
+      [](const FilterType& b, const FilterType& clone) {
+        return -0.5 * (clone.GetAccumulatedCost() - b.GetAccumulatedCost());
+      },
+      scores);
+}
+
+}  // namespace tsif
+
+#endif  // TSIF_HYPOTHESES_H_
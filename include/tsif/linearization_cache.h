@@ -0,0 +1,76 @@
+#ifndef TSIF_LINEARIZATION_CACHE_H_
+#define TSIF_LINEARIZATION_CACHE_H_
+
+#include <deque>
+#include <mutex>
+
+#include "tsif/utils/common.h"
+
+namespace tsif{
+
+/*! \brief Quantities shared through the LinearizationCache.
+ */
+enum class CachedQuantity : int {
+  kRotationMatrix,            // Rotation matrix of a quaternion element
+  kCameraRotationalVelocity,  // C_VI*ror (see BearingFindif)
+  kCameraVelocity             // C_VI*(vel + ror x vep) (see BearingFindif and DistanceFindif)
+};
+
+/*! \brief Linearization Cache.
+ *         Step-scoped storage of derived quantities (rotation matrices, velocities, ...) which several residuals compute
+ *         from the same state elements. Entries are keyed by the input (0: previous, 1: current state), the quantity
+ *         and the IDs of the involved elements, and are computed lazily on first access after Invalidate(). Returned
+ *         references stay valid until the cache is destroyed. Get may be called concurrently (parallel residual
+ *         evaluation), copies start out empty.
+ */
+template<typename S = double>
+class LinearizationCache{
+ public:
+  typedef std::array<int,6> Key;
+  static constexpr int kNoId = std::numeric_limits<int>::min();
+  static Key MakeKey(int input, CachedQuantity quantity, int id0, int id1 = kNoId, int id2 = kNoId, int id3 = kNoId){
+    return Key({input,static_cast<int>(quantity),id0,id1,id2,id3});
+  }
+  LinearizationCache(): stamp_(0){}
+  LinearizationCache(const LinearizationCache& /*other*/): stamp_(0){}
+  LinearizationCache& operator=(const LinearizationCache& /*other*/){
+    Invalidate();
+    return *this;
+  }
+  void Invalidate(){
+    stamp_++;
+  }
+  template<typename T, typename F>
+  const T& Get(const Key& key, F compute){
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::deque<Entry<T>>& entries = std::get<std::deque<Entry<T>>>(entries_);
+    for(auto& entry : entries){
+      if(entry.key_ == key){
+        if(entry.stamp_ != stamp_){
+          entry.value_ = compute();
+          entry.stamp_ = stamp_;
+        }
+        return entry.value_;
+      }
+    }
+    entries.push_back(Entry<T>{key,stamp_,compute()});
+    return entries.back().value_;
+  }
+  const Mat<3,3,S>& GetRotationMatrix(int input, int id, const QuatT<S>& q){
+    return Get<Mat<3,3,S>>(MakeKey(input,CachedQuantity::kRotationMatrix,id),[&q](){ return q.toRotationMatrix(); });
+  }
+ private:
+  template<typename T>
+  struct Entry{
+    Key key_;
+    long stamp_;
+    T value_;
+  };
+  long stamp_;
+  std::mutex mutex_;
+  std::tuple<std::deque<Entry<Mat<3,3,S>>>,std::deque<Entry<Vec<3,S>>>> entries_;
+};
+
+} // namespace tsif
+
+#endif  // TSIF_LINEARIZATION_CACHE_H_
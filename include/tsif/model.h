@@ -6,9 +6,43 @@
 
 namespace tsif {
 
+/*! \brief Jacobian Coloring.
+ *         Sparsity pattern of a Jacobian and a partition of its columns into groups which share no non-zero row.
+ *         All columns of a group can be perturbed together when computing finite differences.
+ */
+struct JacColoring {
+  Eigen::Matrix<bool, -1, -1> pattern_;
+  std::vector<std::vector<int>> groups_;
+  JacColoring() = default;
+  explicit JacColoring(const Eigen::Matrix<bool, -1, -1>& pattern) { SetPattern(pattern); }
+  /*! \brief Greedy coloring: every column joins the first group it does not share a non-zero row with.
+   */
+  void SetPattern(const Eigen::Matrix<bool, -1, -1>& pattern) {
+    pattern_ = pattern;
+    groups_.clear();
+    std::vector<Eigen::Matrix<bool, -1, 1>> rows;
+    for (int j = 0; j < pattern_.cols(); j++) {
+      unsigned int g = 0;
+      while (g < groups_.size() && (rows[g].array() && pattern_.col(j).array()).any()) {
+        g++;
+      }
+      if (g == groups_.size()) {
+        groups_.emplace_back();
+        rows.push_back(Eigen::Matrix<bool, -1, 1>::Constant(pattern_.rows(), false));
+      }
+      groups_[g].push_back(j);
+      rows[g] = rows[g].array() || pattern_.col(j).array();
+    }
+  }
+  int GetGroupCount() const { return groups_.size(); }
+};
+
 template <typename Derived, typename Out, typename... Ins>
 class Model {
  public:
+  typedef typename ElementVectorScalarTrait<Ins..., Out>::Type Scalar;
+  typedef MatRef<-1, -1, Scalar> MatRefX;
+  typedef Mat<-1, -1, Scalar> MatX;
   ~Model(){};
   int Eval(typename Out::Ref out, const std::tuple<typename Ins::CRef...> ins) { return static_cast<Derived&>(*this).EvalImpl(out, ins); }
   template <int N>
@@ -23,15 +57,15 @@ class Model {
     Out outRef, outDis;
     Eval(outRef, insRef);
     std::tuple<Ins...> insDis = insRef;
-    Vec<inDim> inDif;
-    Vec<outDim> outDif;
+    Vec<inDim, Scalar> inDif;
+    Vec<outDim, Scalar> outDif;
     for (unsigned int j = 0; j < inDim; j++) {
       inDif.setZero();
       inDif(j) = d;
       std::get<N>(insRef).template GetElement<I>().Boxplus(inDif, std::get<N>(insDis).template GetElement<I>());
       Eval(outDis, insDis);
       outDis.Boxminus(outRef, outDif);
-      J.col(std::get<N>(insRef).Start(I) + j) = outDif / d;
+      J.col(std::get<N>(insRef).Start(I) + j) = outDif / Scalar(d);
     }
     return 0;
   }
@@ -45,6 +79,79 @@ class Model {
   int JacFindifFull(double /*d*/, MatRefX /*J*/, const std::tuple<typename Ins::CRef...> /*insRef*/) {
     return 0;
   }
+  /*! \brief Detects the sparsity pattern of the Jacobian with respect to input N from a full finite difference
+   *         Jacobian at the given inputs. Entries with a magnitude below th are considered structurally zero, so the
+   *         inputs should be generic (e.g. random) in order not to miss entries.
+   */
+  template <int N>
+  int JacSparsity(double d, double th, JacColoring& coloring, const std::tuple<typename Ins::CRef...> ins) {
+    MatX J(Out::Dim(), std::get<N>(ins).Dim());
+    J.setZero();
+    JacFindifFull<N>(d, J, ins);
+    coloring.SetPattern((J.array().abs() > Scalar(th)).matrix());
+    return 0;
+  }
+  /*! \brief Finite difference Jacobian with respect to input N which perturbs all columns of a coloring group at once.
+   *         Needs one evaluation per group (two with central differences) instead of one per column. Entries outside
+   *         the sparsity pattern are left untouched.
+   */
+  template <int N>
+  int JacFindifColored(double d, MatRefX J, const JacColoring& coloring, const std::tuple<typename Ins::CRef...> insRef,
+                       bool central = false) {
+    typedef typename std::tuple_element<N, std::tuple<Ins...>>::type In;
+    const int outDim = Out::Dim();
+    const int inDim = std::get<N>(insRef).Dim();
+    assert(coloring.pattern_.rows() == outDim && coloring.pattern_.cols() == inDim);
+    Out outRef, outDis;
+    Eval(outRef, insRef);
+    std::tuple<Ins...> insDis = insRef;
+    Vec<In::Dim(), Scalar> inDif;
+    Vec<Out::Dim(), Scalar> outDif, outDifNeg;
+    for (const auto& group : coloring.groups_) {
+      inDif.setZero();
+      for (int j : group) {
+        inDif(j) = d;
+      }
+      std::get<N>(insRef).Boxplus(inDif, std::get<N>(insDis));
+      Eval(outDis, insDis);
+      outDis.Boxminus(outRef, outDif);
+      if (central) {
+        std::get<N>(insRef).Boxplus(-inDif, std::get<N>(insDis));
+        Eval(outDis, insDis);
+        outDis.Boxminus(outRef, outDifNeg);
+        outDif = (outDif - outDifNeg) / Scalar(2);
+      }
+      for (int j : group) {
+        for (int r = 0; r < outDim; r++) {
+          if (coloring.pattern_(r, j)) {
+            J(r, j) = outDif(r) / Scalar(d);
+          }
+        }
+      }
+    }
+    return 0;
+  }
+  /*! \brief Largest absolute difference between the Jacobian with respect to input N and its finite difference
+   *         approximation (optionally central). Does not print anything and is thus suited for automated checks.
+   */
+  template <int N>
+  double JacError(double d, const std::tuple<typename Ins::CRef...> ins, bool central = false) {
+    const int outDim = Out::Dim();
+    const int inDim = std::get<N>(ins).Dim();
+    if ((outDim == 0) | (inDim == 0)) {
+      return 0;
+    }
+    MatX J = MatX::Zero(outDim, inDim);
+    MatX J_FD = MatX::Zero(outDim, inDim);
+    Jac<N>(J, ins);
+    if (central) {
+      const JacColoring dense(Eigen::Matrix<bool, -1, -1>::Constant(outDim, inDim, true));
+      JacFindifColored<N>(d, J_FD, dense, ins, true);
+    } else {
+      JacFindifFull<N>(d, J_FD, ins);
+    }
+    return (J - J_FD).template cast<double>().array().abs().maxCoeff();
+  }
   template <int N>
   int JacTest(double th, double d, const std::tuple<typename Ins::CRef...> ins) {
     const int outDim = Out::Dim();
@@ -59,7 +166,7 @@ class Model {
       TSIF_LOG("Analytical Jacobian:\n" << J);
       TSIF_LOG("Numerical Jacobian:\n" << J_FD);
       typename MatX::Index maxRow, maxCol = 0;
-      const double r = (J - J_FD).array().abs().maxCoeff(&maxRow, &maxCol);
+      const double r = (J - J_FD).template cast<double>().array().abs().maxCoeff(&maxRow, &maxCol);
       if (r > th) {
         std::cout << "\033[31m==== Model jacInput (" << N << ") Test failed: " << r << " is larger than " << th << " at row " << maxRow
                   << " and col " << maxCol << " ====" << "  " << J(maxRow, maxCol) << " vs " << J_FD(maxRow, maxCol) << "\033[0m"
@@ -1,18 +1,52 @@
 #ifndef TSIF_RESIDUAL_H_
 #define TSIF_RESIDUAL_H_
 
+#include "tsif/autodiff.h"
+#include "tsif/linearization_cache.h"
 #include "tsif/model.h"
 #include "tsif/utils/common.h"
 
 namespace tsif {
 
-template <typename Out, typename Pre, typename Cur, typename Meas>
-class Residual : public Model<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur> {
+/*! \brief Robust loss used for iteratively reweighting the whitened residual blocks.
+ */
+enum class RobustLoss { kNone, kHuber, kCauchy };
+
+/*! \brief Detects measurements which deliver their own noise covariance (HasCovariance() and GetCovariance()).
+ */
+template <typename Meas, typename = void>
+struct HasCovarianceTrait : std::false_type {};
+template <typename Meas>
+struct HasCovarianceTrait<Meas, std::void_t<decltype(std::declval<const Meas&>().GetCovariance()),
+                                            decltype(std::declval<const Meas&>().HasCovariance())>> : std::true_type {};
+
+/*! \brief Detects residuals declaring static constexpr bool kConstantJacobian = true. Their Jacobians must not depend on
+ *         the state, the measurement or dt_, which may only enter through GetWeight().
+ */
+template <typename R, typename = void>
+struct ConstantJacobianTrait : std::false_type {};
+template <typename R>
+struct ConstantJacobianTrait<R, std::enable_if_t<R::kConstantJacobian>> : std::true_type {};
+
+/*! \brief Residual Base.
+ *         CRTP base of all residuals. The filter holds residuals by their concrete type and calls EvalRes, JacPre, JacCur,
+ *         AddNoise, GetWeight, SplitMeasurements and MergeMeasurements without virtual dispatch. Derived classes hide the
+ *         defaults below with their own (non-virtual) implementations. Residuals providing a scalar rebind
+ *         (template <typename T> using Rebind = ...) get JacPre and JacCur by automatic differentiation of EvalRes.
+ *         Jacobians are written at the columns pre.Start(I) and cur.Start(I). The filter passes compact views of the
+ *         inputs (CompactLayout), such that J is Output::Dim() x Previous::Dim() (or Current::Dim()).
+ */
+template <typename Derived, typename Out, typename Pre, typename Cur, typename Meas>
+class ResidualBase : public Model<Derived, Out, Pre, Cur> {
  public:
+  typedef Model<Derived, Out, Pre, Cur> Base;
+  using typename Base::MatRefX;
+  using typename Base::Scalar;
   typedef Out Output;
   typedef Pre Previous;
   typedef Cur Current;
   typedef Meas Measurement;
+  typedef Mat<Out::Dim(), Out::Dim(), Scalar> NoiseMat;
   std::shared_ptr<const Meas> meas_;
   double dt_;
   double w_;
@@ -20,29 +54,63 @@ class Residual : public Model<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur> {
   const bool isMergeable_;  // Can two measurements be merged into one (should be same as isSplitable)
   const bool isMandatory_;  // Is this measurement required at every timestep (should then typically be splitable)
   bool isActive_;           // Temporary, is a measurement currently available
-  Residual(bool isSplitable = true, bool isMergeable = true, bool isMandatory = true)
+  bool isRejected_;         // Temporary, has the residual been gated as outlier in the current update
+  double gateTh_;           // Chi-square threshold on the normalized innovation squared (gating disabled if <= 0)
+  RobustLoss loss_;         // Robust loss applied to the whitened residual
+  double lossTh_;           // Scale of the robust loss (in whitened units)
+  double nis_;              // Normalized innovation squared y^T * (R + H*P*H^T)^-1 * y of the last gating
+  int rejectionCount_;      // Number of updates in which the residual has been gated
+  bool hasNoiseModel_;      // Is W_ applied on top of the scalar weight
+  NoiseMat W_;              // Upper triangular whitening matrix of the noise model (W_^T * W_ = R^-1)
+  LinearizationCache<Scalar>* cache_;  // Shared by the residuals of a filter while it constructs its problem
+  RebindCache rebindCache_;            // Rebound residuals of the automatic differentiation (not copied)
+  ResidualBase(bool isSplitable = true, bool isMergeable = true, bool isMandatory = true)
       : meas_(nullptr), isSplitable_(isSplitable), isMergeable_(isMergeable), isMandatory_(isMandatory) {
     dt_ = 0.1;
     w_ = 1.0;
     isActive_ = false;
-    std::shared_ptr<Meas> meas = std::make_shared<Meas>();
-    meas->SetRandom();
-    meas_ = meas;
+    isRejected_ = false;
+    gateTh_ = 0.0;
+    loss_ = RobustLoss::kNone;
+    lossTh_ = 1.0;
+    nis_ = 0.0;
+    rejectionCount_ = 0;
+    hasNoiseModel_ = false;
+    W_.setIdentity();
+    cache_ = nullptr;
+    if (!RebindConstruction::IsActive()) {
+      std::shared_ptr<Meas> meas = std::make_shared<Meas>();
+      meas->SetRandom();
+      meas_ = meas;
+    }
+  }
+  int EvalRes(typename Out::Ref /*out*/, const typename Pre::CRef /*pre*/, const typename Cur::CRef /*cur*/) { return 1; }
+  int JacPre(MatRefX J, const typename Pre::CRef pre, const typename Cur::CRef cur) { return JacPreAutoDiff(J, pre, cur); }
+  int JacCur(MatRefX J, const typename Pre::CRef pre, const typename Cur::CRef cur) { return JacCurAutoDiff(J, pre, cur); }
+  int JacPreAutoDiff(MatRefX J, const typename Pre::CRef pre, const typename Cur::CRef cur) {
+    if constexpr (HasRebindTrait<Derived>::value) {
+      JacAutoDiff<0>(Self(), rebindCache_, J, pre, cur);
+      return 0;
+    }
+    return 1;
+  }
+  int JacCurAutoDiff(MatRefX J, const typename Pre::CRef pre, const typename Cur::CRef cur) {
+    if constexpr (HasRebindTrait<Derived>::value) {
+      JacAutoDiff<1>(Self(), rebindCache_, J, pre, cur);
+      return 0;
+    }
+    return 1;
   }
-  virtual ~Residual(){};
-  virtual int EvalRes(typename Out::Ref /*out*/, const typename Pre::CRef /*pre*/, const typename Cur::CRef /*cur*/) { return 1; }
-  virtual int JacPre(MatRefX /*J*/, const typename Pre::CRef /*pre*/, const typename Cur::CRef /*cur*/) { return 1; }
-  virtual int JacCur(MatRefX /*J*/, const typename Pre::CRef /*pre*/, const typename Cur::CRef /*cur*/) { return 1; }
   int EvalImpl(typename Out::Ref out, const std::tuple<typename Pre::CRef, typename Cur::CRef> ins) {
-    return EvalRes(out, std::get<0>(ins), std::get<1>(ins));
+    return Self().EvalRes(out, std::get<0>(ins), std::get<1>(ins));
   }
   template <int N, typename std::enable_if<N == 0>::type* = nullptr>
   int JacImpl(MatRefX J, const std::tuple<typename Pre::CRef, typename Cur::CRef> ins) {
-    return JacPre(J, std::get<0>(ins), std::get<1>(ins));
+    return Self().JacPre(J, std::get<0>(ins), std::get<1>(ins));
   }
   template <int N, typename std::enable_if<N == 1>::type* = nullptr>
   int JacImpl(MatRefX J, const std::tuple<typename Pre::CRef, typename Cur::CRef> ins) {
-    return JacCur(J, std::get<0>(ins), std::get<1>(ins));
+    return Self().JacCur(J, std::get<0>(ins), std::get<1>(ins));
   }
   int JacPreTest(double th, double d, const typename Pre::CRef pre, const typename Cur::CRef cur) {
     return this->template JacTest<0>(th, d, std::forward_as_tuple(pre, cur));
@@ -64,7 +132,7 @@ class Residual : public Model<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur> {
     cur.SetRandom();
     return JacCurTest(th, d, pre, cur);
   }
-  virtual void SplitMeasurements(const TimePoint& /*t0*/, const TimePoint& /*t1*/, const TimePoint& /*t2*/,
+  void SplitMeasurements(const TimePoint& /*t0*/, const TimePoint& /*t1*/, const TimePoint& /*t2*/,
                                  std::shared_ptr<const Meas>& /*m0*/, std::shared_ptr<const Meas>& m1,
                                  std::shared_ptr<const Meas>& m2) const {
     if (isSplitable_) {
@@ -73,11 +141,11 @@ class Residual : public Model<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur> {
       assert(false);
     }
   }
-  virtual void MergeMeasurements(const TimePoint& t0, const TimePoint& t1, const TimePoint& t2, std::shared_ptr<const Meas>& /*m0*/,
+  void MergeMeasurements(const TimePoint& t0, const TimePoint& t1, const TimePoint& t2, std::shared_ptr<const Meas>& /*m0*/,
                                  std::shared_ptr<const Meas>& m1, std::shared_ptr<const Meas>& m2) const {
     if (isMergeable_) {
       std::shared_ptr<Meas> newMeas = std::make_shared<Meas>();
-      Vec<Meas::Dim()> dif;
+      Vec<Meas::Dim(), typename Meas::Scalar> dif;
       m1->Boxminus(*m2, dif);
       m2->Boxplus(toSec(t1 - t0) / toSec(t2 - t0) * dif, *newMeas);
       m2 = newMeas;
@@ -85,30 +153,195 @@ class Residual : public Model<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur> {
       assert(false);
     }
   }
-  virtual void AddNoise(typename Out::Ref out, MatRefX J_pre, MatRefX J_cur, const typename Previous::CRef /*pre*/,
-                        const typename Current::CRef /*cur*/) {
-    AddWeight(GetWeight(), out, J_pre, J_cur);
+  /*! \brief Whitens the residual with the scalar weight and, if available, the whitening matrix of the noise model.
+   *         A covariance delivered with the measurement takes precedence over W_. Only the Jacobian columns of the
+   *         residual's own elements are touched.
+   */
+  void AddNoise(typename Out::Ref out, MatRefX J_pre, MatRefX J_cur, const typename Previous::CRef pre,
+                const typename Current::CRef cur) {
+    const NoiseMat* W = GetWhitening();
+    if (W != nullptr) {
+      AddWhitening(Self().GetWeight(), *W, out, J_pre, J_cur, pre, cur);
+    } else {
+      AddWeight(Self().GetWeight(), out, J_pre, J_cur, pre, cur);
+    }
   }
   void AddWeight(double w, typename Out::Ref out, MatRefX J_pre, MatRefX J_cur) {
     out.Scale(w);
     J_pre *= w;
     J_cur *= w;
   }
-  virtual double GetWeight() { return w_; }
+  void AddWeight(double w, typename Out::Ref out, MatRefX J_pre, MatRefX J_cur, const typename Previous::CRef pre,
+                 const typename Current::CRef cur) {
+    out.Scale(w);
+    for (int c = 0; c < Previous::kN; c++) {
+      J_pre.middleCols(pre.Start(Previous::kIds[c]), Previous::kDims[c]) *= Scalar(w);
+    }
+    for (int c = 0; c < Current::kN; c++) {
+      J_cur.middleCols(cur.Start(Current::kIds[c]), Current::kDims[c]) *= Scalar(w);
+    }
+  }
+  void AddWhitening(double w, const NoiseMat& W, typename Out::Ref out, MatRefX J_pre, MatRefX J_cur,
+                    const typename Previous::CRef pre, const typename Current::CRef cur) {
+    const NoiseMat Ww = Scalar(w) * W;
+    Vec<Out::Dim(), Scalar> y;
+    out.GetVec(y);
+    y = Ww.template triangularView<Eigen::Upper>() * y;
+    Out zero;
+    zero.SetIdentity();
+    zero.Boxplus(y, out);
+    for (int c = 0; c < Previous::kN; c++) {
+      auto J = J_pre.middleCols(pre.Start(Previous::kIds[c]), Previous::kDims[c]);
+      J = Ww.template triangularView<Eigen::Upper>() * J;
+    }
+    for (int c = 0; c < Current::kN; c++) {
+      auto J = J_cur.middleCols(cur.Start(Current::kIds[c]), Current::kDims[c]);
+      J = Ww.template triangularView<Eigen::Upper>() * J;
+    }
+  }
+  /*! \brief Takes over the parameters of a residual of the same kind with another scalar type, e.g. of the source of a
+   *         rebound residual (see JacAutoDiff). Residuals with parameters of their own hide it, copy them and
+   *         call this one. cache_ is not taken over, it holds values of the other scalar type.
+   */
+  template <typename Other>
+  void CopyParameters(const Other& other) {
+    meas_ = other.meas_;
+    dt_ = other.dt_;
+    w_ = other.w_;
+    isActive_ = other.isActive_;
+    isRejected_ = other.isRejected_;
+    gateTh_ = other.gateTh_;
+    loss_ = other.loss_;
+    lossTh_ = other.lossTh_;
+    hasNoiseModel_ = other.hasNoiseModel_;
+    W_ = other.W_.template cast<Scalar>();
+    cache_ = nullptr;
+  }
+  double GetWeight() { return w_; }
+  /*! \brief Sets a full noise covariance R, ordered like the output vector. It acts on top of GetWeight().
+   */
+  void SetNoiseCovariance(const NoiseMat& R) {
+    W_ = ComputeWhitening(R);
+    hasNoiseModel_ = true;
+  }
+  void ClearNoiseModel() { hasNoiseModel_ = false; }
+  /*! \brief Upper triangular W with W^T * W = R^-1, i.e. the Cholesky factor of the information matrix.
+   */
+  static NoiseMat ComputeWhitening(const NoiseMat& R) {
+    const NoiseMat info = R.llt().solve(NoiseMat::Identity());
+    return info.llt().matrixU();
+  }
+  /*! \brief Whitening matrix for the current measurement, nullptr if only the scalar weight applies. The factorization
+   *         of a measurement covariance is cached until the measurement changes.
+   */
+  const NoiseMat* GetWhitening() {
+    if constexpr (HasCovarianceTrait<Meas>::value) {
+      if (meas_ && meas_->HasCovariance()) {
+        if (meas_ != noiseMeas_) {
+          measW_ = ComputeWhitening(meas_->GetCovariance().template cast<Scalar>());
+          noiseMeas_ = meas_;
+        }
+        return &measW_;
+      }
+    }
+    return hasNoiseModel_ ? &W_ : nullptr;
+  }
+  /*! \brief IRLS weight of the robust loss for the residual block whitened by AddNoise. The filter scales the Gram
+   *         matrix and the gradient of the block with it.
+   */
+  double EvalRobustWeight(const typename Out::CRef out) const {
+    if (loss_ == RobustLoss::kNone) {
+      return 1.0;
+    }
+    Vec<Out::Dim(), Scalar> y;
+    out.GetVec(y);
+    const double r2 = double(y.squaredNorm());
+    if (loss_ == RobustLoss::kHuber) {
+      const double r = std::sqrt(r2);
+      return r > lossTh_ ? lossTh_ / r : 1.0;
+    }
+    return 1.0 / (1.0 + r2 / (lossTh_ * lossTh_));
+  }
+  /*! \brief Stores the normalized innovation squared computed by the filter (see Filter::EvaluateInnovations) and rejects the
+   *         block if it exceeds gateTh_. Returns false if rejected.
+   */
+  bool Gate(double nis) {
+    nis_ = nis;
+    if (gateTh_ > 0 && nis_ > gateTh_) {
+      isRejected_ = true;
+      rejectionCount_++;
+      return false;
+    }
+    return true;
+  }
+  /*! \brief Rotation matrix of the quaternion element I of input N (0: previous, 1: current). Taken from cache_ if set.
+   */
+  template <int N, int I, typename In>
+  Mat<3, 3, Scalar> GetRotationMatrix(const In& in) {
+    if (cache_ != nullptr) {
+      return cache_->GetRotationMatrix(N, I, in.template Get<I>());
+    }
+    return in.template Get<I>().toRotationMatrix();
+  }
+  /*! \brief Derived quantity which is computed once per linearization if cache_ is set.
+   */
+  template <typename T, typename F>
+  T GetCached(const typename LinearizationCache<Scalar>::Key& key, F compute) {
+    if (cache_ != nullptr) {
+      return cache_->template Get<T>(key, compute);
+    }
+    return compute();
+  }
   template <int OUT, int STA, typename std::enable_if<(STA >= 0 & OUT >= 0)>::type* = nullptr>
   void SetJacCur(MatRefX J, const typename Current::CRef cur,
-                 MatCRef<Output::template GetElementDim<OUT>(), Current::template GetElementDim<STA>()> Jsub) {
-    J.block<Output::template GetElementDim<OUT>(), Current::template GetElementDim<STA>()>(Output::Start(OUT), cur.Start(STA)) = Jsub;
+                 MatCRef<Output::template GetElementDim<OUT>(), Current::template GetElementDim<STA>(), Scalar> Jsub) {
+    J.template block<Output::template GetElementDim<OUT>(), Current::template GetElementDim<STA>()>(Output::Start(OUT), cur.Start(STA)) = Jsub;
   }
   template <int OUT, int STA, typename std::enable_if<(STA < 0 | OUT < 0)>::type* = nullptr>
-  void SetJacCur(MatRefX /*J*/, const typename Current::CRef /*cur*/, MatCRefX /*Jsub*/) {}
+  void SetJacCur(MatRefX /*J*/, const typename Current::CRef /*cur*/, MatCRef<-1, -1, Scalar> /*Jsub*/) {}
   template <int OUT, int STA, typename std::enable_if<(STA >= 0 & OUT >= 0)>::type* = nullptr>
   void SetJacPre(MatRefX J, const typename Previous::CRef pre,
-                 MatCRef<Output::template GetElementDim<OUT>(), Previous::template GetElementDim<STA>()> Jsub) {
-    J.block<Output::template GetElementDim<OUT>(), Previous::template GetElementDim<STA>()>(Output::Start(OUT), pre.Start(STA)) = Jsub;
+                 MatCRef<Output::template GetElementDim<OUT>(), Previous::template GetElementDim<STA>(), Scalar> Jsub) {
+    J.template block<Output::template GetElementDim<OUT>(), Previous::template GetElementDim<STA>()>(Output::Start(OUT), pre.Start(STA)) = Jsub;
   }
   template <int OUT, int STA, typename std::enable_if<(STA < 0 | OUT < 0)>::type* = nullptr>
-  void SetJacPre(MatRefX /*J*/, const typename Previous::CRef /*pre*/, MatCRefX /*Jsub*/) {}
+  void SetJacPre(MatRefX /*J*/, const typename Previous::CRef /*pre*/, MatCRef<-1, -1, Scalar> /*Jsub*/) {}
+
+ protected:
+  Derived& Self() { return static_cast<Derived&>(*this); }
+  std::shared_ptr<const Meas> noiseMeas_;  // Measurement of the cached whitening measW_
+  NoiseMat measW_;
+};
+
+/*! \brief Residual.
+ *         Virtual adapter around ResidualBase for residuals which override the interface at runtime. Shipped residuals
+ *         derive from ResidualBase directly.
+ */
+template <typename Out, typename Pre, typename Cur, typename Meas>
+class Residual : public ResidualBase<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur, Meas> {
+ public:
+  typedef ResidualBase<Residual<Out, Pre, Cur, Meas>, Out, Pre, Cur, Meas> Base;
+  using typename Base::MatRefX;
+  using Base::Base;
+  virtual ~Residual(){};
+  virtual int EvalRes(typename Out::Ref out, const typename Pre::CRef pre, const typename Cur::CRef cur) {
+    return Base::EvalRes(out, pre, cur);
+  }
+  virtual int JacPre(MatRefX J, const typename Pre::CRef pre, const typename Cur::CRef cur) { return Base::JacPre(J, pre, cur); }
+  virtual int JacCur(MatRefX J, const typename Pre::CRef pre, const typename Cur::CRef cur) { return Base::JacCur(J, pre, cur); }
+  virtual void SplitMeasurements(const TimePoint& t0, const TimePoint& t1, const TimePoint& t2, std::shared_ptr<const Meas>& m0,
+                                 std::shared_ptr<const Meas>& m1, std::shared_ptr<const Meas>& m2) const {
+    Base::SplitMeasurements(t0, t1, t2, m0, m1, m2);
+  }
+  virtual void MergeMeasurements(const TimePoint& t0, const TimePoint& t1, const TimePoint& t2, std::shared_ptr<const Meas>& m0,
+                                 std::shared_ptr<const Meas>& m1, std::shared_ptr<const Meas>& m2) const {
+    Base::MergeMeasurements(t0, t1, t2, m0, m1, m2);
+  }
+  virtual void AddNoise(typename Out::Ref out, MatRefX J_pre, MatRefX J_cur, const typename Pre::CRef pre,
+                        const typename Cur::CRef cur) {
+    Base::AddNoise(out, J_pre, J_cur, pre, cur);
+  }
+  virtual double GetWeight() { return Base::GetWeight(); }
 };
 
 }  // namespace tsif
@@ -18,39 +18,46 @@ class MeasAcc: public ElementVector<Element<Vec3,0>>{
   }
 };
 
-template<int OUT_VEL, int STA_VEL, int STA_ATT, int STA_ROR, int STA_ACB>
-using AccelerometerPredictionBase = Residual<ElementVector<Element<Vec3,OUT_VEL>>,
-                                           ElementVector<Element<Vec3,STA_VEL>,Element<Quat,STA_ATT>,Element<Vec3,STA_ROR>,Element<Vec3,STA_ACB>>,
-                                           ElementVector<Element<Vec3,STA_VEL>>,
-                                           MeasAcc>;
-
-template<int OUT_VEL, int STA_VEL, int STA_ATT, int STA_ROR, int STA_ACB>
-class AccelerometerPrediction: public AccelerometerPredictionBase<OUT_VEL,STA_VEL,STA_ATT,STA_ROR,STA_ACB>{
+template<int OUT_VEL, int STA_VEL, int STA_ATT, int STA_ROR, int STA_ACB, typename S = double>
+class AccelerometerPrediction;
+
+template<int OUT_VEL, int STA_VEL, int STA_ATT, int STA_ROR, int STA_ACB, typename S = double>
+using AccelerometerPredictionBase = ResidualBase<AccelerometerPrediction<OUT_VEL,STA_VEL,STA_ATT,STA_ROR,STA_ACB,S>,
+                                                 ElementVector<Element<Vec<3,S>,OUT_VEL>>,
+                                                 ElementVector<Element<Vec<3,S>,STA_VEL>,Element<QuatT<S>,STA_ATT>,Element<Vec<3,S>,STA_ROR>,Element<Vec<3,S>,STA_ACB>>,
+                                                 ElementVector<Element<Vec<3,S>,STA_VEL>>,
+                                                 MeasAcc>;
+
+template<int OUT_VEL, int STA_VEL, int STA_ATT, int STA_ROR, int STA_ACB, typename S>
+class AccelerometerPrediction: public AccelerometerPredictionBase<OUT_VEL,STA_VEL,STA_ATT,STA_ROR,STA_ACB,S>{
  public:
-  typedef AccelerometerPredictionBase<OUT_VEL,STA_VEL,STA_ATT,STA_ROR,STA_ACB> Base;
+  typedef AccelerometerPredictionBase<OUT_VEL,STA_VEL,STA_ATT,STA_ROR,STA_ACB,S> Base;
+  using typename Base::MatRefX;
   using Base::dt_;
   using Base::w_;
   using Base::meas_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
-  const Vec3 g_;
-  AccelerometerPrediction(bool isSplitable = true,bool isMergeable = true,bool isMandatory = true): Base(isSplitable,isMergeable,isMandatory), g_(0,0,-9.81){}
+  template<typename T>
+  using Rebind = AccelerometerPrediction<OUT_VEL,STA_VEL,STA_ATT,STA_ROR,STA_ACB,T>;
+  const Vec<3,S> g_;
+  AccelerometerPrediction(bool isSplitable = true,bool isMergeable = true,bool isMandatory = true): Base(isSplitable,isMergeable,isMandatory), g_(Vec<3>(0,0,-9.81).cast<S>()){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef pre, const typename Current::CRef cur){
     out.template Get<OUT_VEL>() = cur.template Get<STA_VEL>()
-        - (Mat3::Identity() - SSM(dt_*pre.template Get<STA_ROR>()))*pre.template Get<STA_VEL>()
-        - dt_*(meas_->GetAcc()-pre.template Get<STA_ACB>()+pre.template Get<STA_ATT>().inverse().toRotationMatrix()*g_);
+        - (Mat<3,3,S>::Identity() - SSM(dt_*pre.template Get<STA_ROR>()))*pre.template Get<STA_VEL>()
+        - dt_*(meas_->GetAcc().template cast<S>()-pre.template Get<STA_ACB>()+this->template GetRotationMatrix<0,STA_ATT>(pre).transpose()*g_);
     return 0;
   }
   int JacPre(MatRefX J, const typename Previous::CRef pre, const typename Current::CRef /*cur*/){
-    this->template SetJacPre<OUT_VEL, STA_VEL>(J, pre, -(Mat3::Identity() - SSM(dt_*pre.template Get<STA_ROR>())));
-    this->template SetJacPre<OUT_VEL, STA_ATT>(J, pre, -pre.template Get<STA_ATT>().inverse().toRotationMatrix()*SSM(g_*dt_));
+    this->template SetJacPre<OUT_VEL, STA_VEL>(J, pre, -(Mat<3,3,S>::Identity() - SSM(dt_*pre.template Get<STA_ROR>())));
+    this->template SetJacPre<OUT_VEL, STA_ATT>(J, pre, -this->template GetRotationMatrix<0,STA_ATT>(pre).transpose()*SSM(g_*dt_));
     this->template SetJacPre<OUT_VEL, STA_ROR>(J, pre, -SSM(dt_*pre.template Get<STA_VEL>()));
-    this->template SetJacPre<OUT_VEL, STA_ACB>(J, pre, dt_*Mat3::Identity());
+    this->template SetJacPre<OUT_VEL, STA_ACB>(J, pre, dt_*Mat<3,3,S>::Identity());
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    this->template SetJacCur<OUT_VEL, STA_VEL>(J, cur, Mat3::Identity());
+    this->template SetJacCur<OUT_VEL, STA_VEL>(J, cur, Mat<3,3,S>::Identity());
     return 0;
   }
   double GetWeight(){
@@ -18,39 +18,46 @@ class MeasAtt: public ElementVector<Element<Quat,0>>{
   }
 };
 
-template<int OUT_ATT, int STA_qIB, int STA_qIJ, int STA_qBV>
-using AttitudeUpdateBase = Residual<ElementVector<Element<Vec3,OUT_ATT>>,
-                                    ElementVector<>,
-                                    ElementVector<Element<Quat,STA_qIB>,
-                                                  Element<Quat,STA_qIJ>,
-                                                  Element<Quat,STA_qBV>>,
-                                    MeasAtt>;
-
-template<int OUT_ATT, int STA_qIB, int STA_qIJ, int STA_qBV>
-class AttitudeUpdate: public AttitudeUpdateBase<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV>{
+template<int OUT_ATT, int STA_qIB, int STA_qIJ, int STA_qBV, typename S = double>
+class AttitudeUpdate;
+
+template<int OUT_ATT, int STA_qIB, int STA_qIJ, int STA_qBV, typename S = double>
+using AttitudeUpdateBase = ResidualBase<AttitudeUpdate<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV,S>,
+                                        ElementVector<Element<Vec<3,S>,OUT_ATT>>,
+                                        ElementVector<>,
+                                        ElementVector<Element<QuatT<S>,STA_qIB>,
+                                                      Element<QuatT<S>,STA_qIJ>,
+                                                      Element<QuatT<S>,STA_qBV>>,
+                                        MeasAtt>;
+
+template<int OUT_ATT, int STA_qIB, int STA_qIJ, int STA_qBV, typename S>
+class AttitudeUpdate: public AttitudeUpdateBase<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV,S>{
  public:
-  typedef AttitudeUpdateBase<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV> Base;
+  typedef AttitudeUpdateBase<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV,S> Base;
+  using typename Base::MatRefX;
   using Base::meas_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
+  template<typename T>
+  using Rebind = AttitudeUpdate<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV,T>;
   AttitudeUpdate(): Base(false,false,false){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
     out.template Get<OUT_ATT>() = Log(cur.template Get<STA_qIJ>().inverse()*
                                       cur.template Get<STA_qIB>()*cur.template Get<STA_qBV>()*
-                                      meas_->GetAtt().inverse());
+                                      meas_->GetAtt().template cast<S>().inverse());
     return 0;
   }
   int JacPre(MatRefX /*J*/, const typename Previous::CRef /*pre*/, const typename Current::CRef /*cur*/){
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    const Vec3 attErr = Log(cur.template Get<STA_qIJ>().inverse()*
+    const Vec<3,S> attErr = Log(cur.template Get<STA_qIJ>().inverse()*
                                       cur.template Get<STA_qIB>()*cur.template Get<STA_qBV>()*
-                                      meas_->GetAtt().inverse());
-    const Mat3 mJI =  cur.template Get<STA_qIJ>().inverse().toRotationMatrix();
-    const Mat3 mIB =  cur.template Get<STA_qIB>().toRotationMatrix();
-    const Mat3 GI = GammaMat(attErr).inverse();
+                                      meas_->GetAtt().template cast<S>().inverse());
+    const Mat<3,3,S> mJI = this->template GetRotationMatrix<1,STA_qIJ>(cur).transpose();
+    const Mat<3,3,S> mIB = this->template GetRotationMatrix<1,STA_qIB>(cur);
+    const Mat<3,3,S> GI = GammaMatInv(attErr);
     this->template SetJacCur<OUT_ATT,STA_qIB>(J,cur,GI*mJI);
     this->template SetJacCur<OUT_ATT,STA_qIJ>(J,cur,-GI*mJI);
     this->template SetJacCur<OUT_ATT,STA_qBV>(J,cur,GI*mJI*mIB);
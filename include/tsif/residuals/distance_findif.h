@@ -6,66 +6,83 @@
 
 namespace tsif{
 
-template<int OUT_DIS, int STA_BEA, int STA_DIS, int STA_VEL, int STA_ROR, int STA_VEP, int STA_VEA, int N>
-using DistanceFindifBase = Residual<ElementVector<Element<std::array<Vec<1>,N>,OUT_DIS>>,
-                                    ElementVector<Element<std::array<UnitVector,N>,STA_BEA>,
-                                                  Element<std::array<double,N>,STA_DIS>,
-                                                  Element<Vec3,STA_VEL>,
-                                                  Element<Vec3,STA_ROR>,
-                                                  Element<Vec3,STA_VEP>,
-                                                  Element<Quat,STA_VEA>>,
-                                    ElementVector<Element<std::array<double,N>,STA_DIS>>,
-                                    MeasEmpty>;
+template<int OUT_DIS, int STA_BEA, int STA_DIS, int STA_VEL, int STA_ROR, int STA_VEP, int STA_VEA, int N, typename S = double, template<typename,size_t> class Array = std::array>
+class DistanceFindif;
 
-template<int OUT_DIS, int STA_BEA, int STA_DIS, int STA_VEL, int STA_ROR, int STA_VEP, int STA_VEA, int N>
-class DistanceFindif: public DistanceFindifBase<OUT_DIS,STA_BEA,STA_DIS,STA_VEL,STA_ROR,STA_VEP,STA_VEA,N>{
+template<int OUT_DIS, int STA_BEA, int STA_DIS, int STA_VEL, int STA_ROR, int STA_VEP, int STA_VEA, int N, typename S = double, template<typename,size_t> class Array = std::array>
+using DistanceFindifBase = ResidualBase<DistanceFindif<OUT_DIS,STA_BEA,STA_DIS,STA_VEL,STA_ROR,STA_VEP,STA_VEA,N,S,Array>,
+                                        ElementVector<Element<std::array<Vec<1,S>,N>,OUT_DIS>>,
+                                        ElementVector<Element<Array<UnitVectorT<S>,N>,STA_BEA>,
+                                                      Element<Array<S,N>,STA_DIS>,
+                                                      Element<Vec<3,S>,STA_VEL>,
+                                                      Element<Vec<3,S>,STA_ROR>,
+                                                      Element<Vec<3,S>,STA_VEP>,
+                                                      Element<QuatT<S>,STA_VEA>>,
+                                        ElementVector<Element<Array<S,N>,STA_DIS>>,
+                                        MeasEmpty>;
+
+template<int OUT_DIS, int STA_BEA, int STA_DIS, int STA_VEL, int STA_ROR, int STA_VEP, int STA_VEA, int N, typename S, template<typename,size_t> class Array>
+class DistanceFindif: public DistanceFindifBase<OUT_DIS,STA_BEA,STA_DIS,STA_VEL,STA_ROR,STA_VEP,STA_VEA,N,S,Array>{
  public:
-  typedef DistanceFindifBase<OUT_DIS,STA_BEA,STA_DIS,STA_VEL,STA_ROR,STA_VEP,STA_VEA,N> Base;
+  typedef DistanceFindifBase<OUT_DIS,STA_BEA,STA_DIS,STA_VEL,STA_ROR,STA_VEP,STA_VEA,N,S,Array> Base;
+  using typename Base::MatRefX;
   using Base::dt_;
   using Base::w_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
+  template<typename T>
+  using Rebind = DistanceFindif<OUT_DIS,STA_BEA,STA_DIS,STA_VEL,STA_ROR,STA_VEP,STA_VEA,N,T,Array>;
   DistanceFindif(): Base(true,true,true), vep_not_fixed_(STA_VEP>=0), vea_not_fixed_(STA_VEA>=0){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef pre, const typename Current::CRef cur){
-    const Mat3 C_VI = pre.template Get<STA_VEA>().toRotationMatrix();
-    const Vec3 vel = C_VI*(pre.template Get<STA_VEL>() + pre.template Get<STA_ROR>().cross(pre.template Get<STA_VEP>()));
+    const Mat<3,3,S> C_VI = this->template GetRotationMatrix<0,STA_VEA>(pre);
+    const Vec<3,S> vel = GetCameraVelocity(pre,C_VI);
     for(int i=0;i<N;i++){
-      const UnitVector& bea = pre.template Get<STA_BEA>()[i];
-      const Vec3 beaVec = bea.GetVec();
-      const double& invDis = pre.template Get<STA_DIS>()[i];
+      if(!IsSlotActive(pre.template Get<STA_DIS>(),i) || !IsSlotActive(cur.template Get<STA_DIS>(),i)){
+        out.template Get<OUT_DIS>()[i].setZero();
+        continue;
+      }
+      const UnitVectorT<S>& bea = pre.template Get<STA_BEA>()[i];
+      const Vec<3,S> beaVec = bea.GetVec();
+      const S& invDis = pre.template Get<STA_DIS>()[i];
       out.template Get<OUT_DIS>()[i](0) = invDis + dt_*beaVec.dot(vel)*invDis*invDis - cur.template Get<STA_DIS>()[i];
     }
     return 0;
   }
   int JacPre(MatRefX J, const typename Previous::CRef pre, const typename Current::CRef cur){
     J.setZero();
-    const Mat3 C_VI = pre.template Get<STA_VEA>().toRotationMatrix();
-    const Vec3 vel = C_VI*(pre.template Get<STA_VEL>() + pre.template Get<STA_ROR>().cross(pre.template Get<STA_VEP>()));
+    const Mat<3,3,S> C_VI = this->template GetRotationMatrix<0,STA_VEA>(pre);
+    const Vec<3,S> vel = GetCameraVelocity(pre,C_VI);
     for(int i=0;i<N;i++){
-      const UnitVector& bea = pre.template Get<STA_BEA>()[i];
-      const Vec3 beaVec = bea.GetVec();
-      const double& invDis = pre.template Get<STA_DIS>()[i];
-      const Mat<1,3> J_vel = dt_*beaVec.transpose()*invDis*invDis;
-      J.block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_VEL)) = J_vel*C_VI;
-      J.block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_ROR)) = -J_vel*C_VI*SSM(pre.template Get<STA_VEP>());
-      J.block<1,1>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_DIS)+1*i) = Mat<1>::Identity()+dt_*2*beaVec.transpose()*vel*invDis;
-      J.block<1,2>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_BEA)+2*i) = dt_*vel.transpose()*invDis*invDis*bea.GetM();
-      if (vep_not_fixed_) J.block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_VEP)) = J_vel*C_VI*SSM(pre.template Get<STA_ROR>());
-      if (vea_not_fixed_) J.block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_VEA)) = - J_vel*SSM(vel);
+      if(!IsSlotActive(pre.template Get<STA_DIS>(),i) || !IsSlotActive(cur.template Get<STA_DIS>(),i)) continue;
+      const UnitVectorT<S>& bea = pre.template Get<STA_BEA>()[i];
+      const Vec<3,S> beaVec = bea.GetVec();
+      const S& invDis = pre.template Get<STA_DIS>()[i];
+      const Mat<1,3,S> J_vel = dt_*beaVec.transpose()*invDis*invDis;
+      J.template block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_VEL)) = J_vel*C_VI;
+      J.template block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_ROR)) = -J_vel*C_VI*SSM(pre.template Get<STA_VEP>());
+      J.template block<1,1>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_DIS)+1*i) = Mat<1,1,S>::Identity()+dt_*2*beaVec.transpose()*vel*invDis;
+      J.template block<1,2>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_BEA)+2*i) = dt_*vel.transpose()*invDis*invDis*bea.GetM();
+      if (vep_not_fixed_) J.template block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_VEP)) = J_vel*C_VI*SSM(pre.template Get<STA_ROR>());
+      if (vea_not_fixed_) J.template block<1,3>(Output::Start(OUT_DIS)+1*i,pre.Start(STA_VEA)) = - J_vel*SSM(vel);
     }
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef pre, const typename Current::CRef cur){
     J.setZero();
     for(int i=0;i<N;i++){
-      J.block<1,1>(Output::Start(OUT_DIS)+1*i,cur.Start(STA_DIS)+1*i) = -Mat<1>::Identity();
+      if(!IsSlotActive(pre.template Get<STA_DIS>(),i) || !IsSlotActive(cur.template Get<STA_DIS>(),i)) continue;
+      J.template block<1,1>(Output::Start(OUT_DIS)+1*i,cur.Start(STA_DIS)+1*i) = -Mat<1,1,S>::Identity();
     }
     return 0;
   }
   double GetWeight(){
     return w_/sqrt(dt_);
   }
+  Vec<3,S> GetCameraVelocity(const typename Previous::CRef pre, const Mat<3,3,S>& C_VI){
+    return this->template GetCached<Vec<3,S>>(LinearizationCache<S>::MakeKey(0,CachedQuantity::kCameraVelocity,STA_VEL,STA_ROR,STA_VEP,STA_VEA),
+                                              [&](){ return Vec<3,S>(C_VI*(pre.template Get<STA_VEL>() + pre.template Get<STA_ROR>().cross(pre.template Get<STA_VEP>()))); });
+  }
  protected:
   const bool vep_not_fixed_;
   const bool vea_not_fixed_;
@@ -18,33 +18,41 @@ class MeasGyr: public ElementVector<Element<Vec3,0>>{
   }
 };
 
-template<int OUT_ROR, int STA_ROR, int STA_GYB>
-using GyroscopeUpdateBase = Residual<ElementVector<Element<Vec3,OUT_ROR>>,
-                                     ElementVector<>,
-                                     ElementVector<Element<Vec3,STA_ROR>,Element<Vec3,STA_GYB>>,
-                                     MeasGyr>;
-
-template<int OUT_ROR, int STA_ROR, int STA_GYB>
-class GyroscopeUpdate: public GyroscopeUpdateBase<OUT_ROR,STA_ROR,STA_GYB>{
+template<int OUT_ROR, int STA_ROR, int STA_GYB, typename S = double>
+class GyroscopeUpdate;
+
+template<int OUT_ROR, int STA_ROR, int STA_GYB, typename S = double>
+using GyroscopeUpdateBase = ResidualBase<GyroscopeUpdate<OUT_ROR,STA_ROR,STA_GYB,S>,
+                                         ElementVector<Element<Vec<3,S>,OUT_ROR>>,
+                                         ElementVector<>,
+                                         ElementVector<Element<Vec<3,S>,STA_ROR>,Element<Vec<3,S>,STA_GYB>>,
+                                         MeasGyr>;
+
+template<int OUT_ROR, int STA_ROR, int STA_GYB, typename S>
+class GyroscopeUpdate: public GyroscopeUpdateBase<OUT_ROR,STA_ROR,STA_GYB,S>{
  public:
-  typedef GyroscopeUpdateBase<OUT_ROR,STA_ROR,STA_GYB> Base;
+  typedef GyroscopeUpdateBase<OUT_ROR,STA_ROR,STA_GYB,S> Base;
+  using typename Base::MatRefX;
   using Base::dt_;
   using Base::w_;
   using Base::meas_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
+  template<typename T>
+  using Rebind = GyroscopeUpdate<OUT_ROR,STA_ROR,STA_GYB,T>;
+  static constexpr bool kConstantJacobian = true;
   GyroscopeUpdate(bool isSplitable = true,bool isMergeable = true,bool isMandatory = true): Base(isSplitable,isMergeable,isMandatory){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    out.template Get<OUT_ROR>() = cur.template Get<STA_ROR>() + cur.template Get<STA_GYB>() - meas_->GetGyr();
+    out.template Get<OUT_ROR>() = cur.template Get<STA_ROR>() + cur.template Get<STA_GYB>() - meas_->GetGyr().template cast<S>();
     return 0;
   }
   int JacPre(MatRefX /*J*/, const typename Previous::CRef /*pre*/, const typename Current::CRef /*cur*/){
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    this->template SetJacCur<OUT_ROR,STA_ROR>(J,cur,Mat3::Identity());
-    this->template SetJacCur<OUT_ROR,STA_GYB>(J,cur,Mat3::Identity());
+    this->template SetJacCur<OUT_ROR,STA_ROR>(J,cur,Mat<3,3,S>::Identity());
+    this->template SetJacCur<OUT_ROR,STA_GYB>(J,cur,Mat<3,3,S>::Identity());
     return 0;
   }
   double GetWeight(){
@@ -10,8 +10,9 @@ namespace tsif{
 
 class MeasPose: public ElementVector<Element<Vec3,0>,Element<Quat,1>>{
  public:
-  MeasPose(): ElementVector<Element<Vec3,0>,Element<Quat,1>>(Vec3(0,0,0),Quat(1,0,0,0)){}
-  MeasPose(const Vec3& pos, const Quat& att): ElementVector<Element<Vec3,0>,Element<Quat,1>>(pos,att){}
+  MeasPose(): ElementVector<Element<Vec3,0>,Element<Quat,1>>(Vec3(0,0,0),Quat(1,0,0,0)), hasCov_(false){}
+  MeasPose(const Vec3& pos, const Quat& att): ElementVector<Element<Vec3,0>,Element<Quat,1>>(pos,att), hasCov_(false){}
+  MeasPose(const Vec3& pos, const Quat& att, const Mat<6>& cov): ElementVector<Element<Vec3,0>,Element<Quat,1>>(pos,att), cov_(cov), hasCov_(true){}
   const Vec3& GetPos() const{
     return Get<0>();
   }
@@ -24,31 +25,49 @@ class MeasPose: public ElementVector<Element<Vec3,0>,Element<Quat,1>>{
   Quat& GetAtt(){
     return Get<1>();
   }
+  // Covariance of position and attitude (in this order), used by the noise model of PoseUpdate
+  bool HasCovariance() const{
+    return hasCov_;
+  }
+  const Mat<6>& GetCovariance() const{
+    return cov_;
+  }
+ protected:
+  Mat<6> cov_;
+  bool hasCov_;
 };
 
-template<int OUT_POS, int OUT_ATT, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, int STA_qBV>
-using PoseUpdateBase = Residual<ElementVector<Element<Vec3,OUT_POS>,Element<Vec3,OUT_ATT>>,
-                                ElementVector<>,
-                                ElementVector<Element<Vec3,STA_IrIB>,
-                                              Element<Quat,STA_qIB>,
-                                              Element<Vec3,STA_IrIJ>,
-                                              Element<Quat,STA_qIJ>,
-                                              Element<Vec3,STA_BrBV>,
-                                              Element<Quat,STA_qBV>>,
-                                MeasPose>;
+template<int OUT_POS, int OUT_ATT, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, int STA_qBV, typename S = double>
+class PoseUpdate;
 
-template<int OUT_POS, int OUT_ATT, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, int STA_qBV>
-class PoseUpdate: public PoseUpdateBase<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,STA_qBV>{
+template<int OUT_POS, int OUT_ATT, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, int STA_qBV, typename S = double>
+using PoseUpdateBase = ResidualBase<PoseUpdate<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,STA_qBV,S>,
+                                    ElementVector<Element<Vec<3,S>,OUT_POS>,Element<Vec<3,S>,OUT_ATT>>,
+                                    ElementVector<>,
+                                    ElementVector<Element<Vec<3,S>,STA_IrIB>,
+                                                  Element<QuatT<S>,STA_qIB>,
+                                                  Element<Vec<3,S>,STA_IrIJ>,
+                                                  Element<QuatT<S>,STA_qIJ>,
+                                                  Element<Vec<3,S>,STA_BrBV>,
+                                                  Element<QuatT<S>,STA_qBV>>,
+                                    MeasPose>;
+
+template<int OUT_POS, int OUT_ATT, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, int STA_qBV, typename S>
+class PoseUpdate: public PoseUpdateBase<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,STA_qBV,S>{
  public:
-  typedef PoseUpdateBase<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,STA_qBV> Base;
+  typedef PoseUpdateBase<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,STA_qBV,S> Base;
+  using typename Base::MatRefX;
   using Base::meas_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
-  PositionUpdate<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV> posUpd_;
-  AttitudeUpdate<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV> attUpd_;
+  template<typename T>
+  using Rebind = PoseUpdate<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,STA_qBV,T>;
+  PositionUpdate<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,S> posUpd_;
+  AttitudeUpdate<OUT_ATT,STA_qIB,STA_qIJ,STA_qBV,S> attUpd_;
   PoseUpdate(): Base(false,false,false){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef pre, const typename Current::CRef cur){
+    ForwardMeas();
     posUpd_.EvalRes(out,pre,cur);
     attUpd_.EvalRes(out,pre,cur);
     return 0;
@@ -57,10 +76,23 @@ class PoseUpdate: public PoseUpdateBase<OUT_POS,OUT_ATT,STA_IrIB,STA_qIB,STA_IrI
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef pre, const typename Current::CRef cur){
+    ForwardMeas();
     posUpd_.JacCur(J.block(Output::Start(OUT_POS),0,3,cur.Dim()),pre,cur);
     attUpd_.JacCur(J.block(Output::Start(OUT_ATT),0,3,cur.Dim()),pre,cur);
     return 0;
   }
+  // Hands the pose measurement (whenever it changes) and the linearization cache on to the wrapped residuals
+  void ForwardMeas(){
+    posUpd_.cache_ = this->cache_;
+    attUpd_.cache_ = this->cache_;
+    if(meas_ != forwardedMeas_){
+      posUpd_.meas_ = std::make_shared<MeasPos>(meas_->GetPos());
+      attUpd_.meas_ = std::make_shared<MeasAtt>(meas_->GetAtt());
+      forwardedMeas_ = meas_;
+    }
+  }
+ protected:
+  std::shared_ptr<const MeasPose> forwardedMeas_;
 };
 
 } // namespace tsif
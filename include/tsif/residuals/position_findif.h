@@ -6,35 +6,43 @@
 
 namespace tsif{
 
-template<int OUT_POS, int STA_POS, int STA_VEL, int STA_ATT>
-using PositionFindifBase = Residual<ElementVector<Element<Vec3,OUT_POS>>,
-                                 ElementVector<Element<Vec3,STA_POS>,Element<Vec3,STA_VEL>,Element<Quat,STA_ATT>>,
-                                 ElementVector<Element<Vec3,STA_POS>>,
-                                 MeasEmpty>;
+template<int OUT_POS, int STA_POS, int STA_VEL, int STA_ATT, typename S = double>
+class PositionFindif;
 
-template<int OUT_POS, int STA_POS, int STA_VEL, int STA_ATT>
-class PositionFindif: public PositionFindifBase<OUT_POS,STA_POS,STA_VEL,STA_ATT>{
+template<int OUT_POS, int STA_POS, int STA_VEL, int STA_ATT, typename S = double>
+using PositionFindifBase = ResidualBase<PositionFindif<OUT_POS,STA_POS,STA_VEL,STA_ATT,S>,
+                                        ElementVector<Element<Vec<3,S>,OUT_POS>>,
+                                        ElementVector<Element<Vec<3,S>,STA_POS>,Element<Vec<3,S>,STA_VEL>,Element<QuatT<S>,STA_ATT>>,
+                                        ElementVector<Element<Vec<3,S>,STA_POS>>,
+                                        MeasEmpty>;
+
+template<int OUT_POS, int STA_POS, int STA_VEL, int STA_ATT, typename S>
+class PositionFindif: public PositionFindifBase<OUT_POS,STA_POS,STA_VEL,STA_ATT,S>{
  public:
-  typedef PositionFindifBase<OUT_POS,STA_POS,STA_VEL,STA_ATT> Base;
+  typedef PositionFindifBase<OUT_POS,STA_POS,STA_VEL,STA_ATT,S> Base;
+  using typename Base::MatRefX;
   using Base::dt_;
   using Base::w_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
+  template<typename T>
+  using Rebind = PositionFindif<OUT_POS,STA_POS,STA_VEL,STA_ATT,T>;
   PositionFindif(): Base(true,true,true){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef pre, const typename Current::CRef cur){
     out.template Get<OUT_POS>() = cur.template Get<STA_POS>() - pre.template Get<STA_POS>()
-      - dt_*pre.template Get<STA_ATT>().toRotationMatrix()*pre.template Get<STA_VEL>();
+      - dt_*this->template GetRotationMatrix<0,STA_ATT>(pre)*pre.template Get<STA_VEL>();
     return 0;
   }
   int JacPre(MatRefX J, const typename Previous::CRef pre, const typename Current::CRef /*cur*/){
-    J.block<3,3>(Output::Start(OUT_POS),pre.Start(STA_POS)) = -Mat3::Identity();
-    J.block<3,3>(Output::Start(OUT_POS),pre.Start(STA_VEL)) = -pre.template Get<STA_ATT>().toRotationMatrix()*dt_;
-    J.block<3,3>(Output::Start(OUT_POS),pre.Start(STA_ATT)) = SSM(dt_*pre.template Get<STA_ATT>().toRotationMatrix()*pre.template Get<STA_VEL>());
+    const Mat<3,3,S> C = this->template GetRotationMatrix<0,STA_ATT>(pre);
+    J.template block<3,3>(Output::Start(OUT_POS),pre.Start(STA_POS)) = -Mat<3,3,S>::Identity();
+    J.template block<3,3>(Output::Start(OUT_POS),pre.Start(STA_VEL)) = -C*dt_;
+    J.template block<3,3>(Output::Start(OUT_POS),pre.Start(STA_ATT)) = SSM(dt_*C*pre.template Get<STA_VEL>());
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    J.block<3,3>(Output::Start(OUT_POS),cur.Start(STA_POS)) = Mat3::Identity();
+    J.template block<3,3>(Output::Start(OUT_POS),cur.Start(STA_POS)) = Mat<3,3,S>::Identity();
     return 0;
   }
   double GetWeight(){
@@ -18,40 +18,46 @@ class MeasPos: public ElementVector<Element<Vec3,0>>{
   }
 };
 
-template<int OUT_POS, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV>
-using PositionUpdateBase = Residual<ElementVector<Element<Vec3,OUT_POS>>,
-                                    ElementVector<>,
-                                    ElementVector<Element<Vec3,STA_IrIB>,
-                                                  Element<Quat,STA_qIB>,
-                                                  Element<Vec3,STA_IrIJ>,
-                                                  Element<Quat,STA_qIJ>,
-                                                  Element<Vec3,STA_BrBV>>,
-                                    MeasPos>;
+template<int OUT_POS, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, typename S = double>
+class PositionUpdate;
 
-template<int OUT_POS, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV>
-class PositionUpdate: public PositionUpdateBase<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV>{
+template<int OUT_POS, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, typename S = double>
+using PositionUpdateBase = ResidualBase<PositionUpdate<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,S>,
+                                        ElementVector<Element<Vec<3,S>,OUT_POS>>,
+                                        ElementVector<>,
+                                        ElementVector<Element<Vec<3,S>,STA_IrIB>,
+                                                      Element<QuatT<S>,STA_qIB>,
+                                                      Element<Vec<3,S>,STA_IrIJ>,
+                                                      Element<QuatT<S>,STA_qIJ>,
+                                                      Element<Vec<3,S>,STA_BrBV>>,
+                                        MeasPos>;
+
+template<int OUT_POS, int STA_IrIB, int STA_qIB, int STA_IrIJ, int STA_qIJ, int STA_BrBV, typename S>
+class PositionUpdate: public PositionUpdateBase<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,S>{
  public:
-  typedef PositionUpdateBase<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV> Base;
+  typedef PositionUpdateBase<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,S> Base;
+  using typename Base::MatRefX;
   using Base::meas_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
+  template<typename T>
+  using Rebind = PositionUpdate<OUT_POS,STA_IrIB,STA_qIB,STA_IrIJ,STA_qIJ,STA_BrBV,T>;
   PositionUpdate(): Base(false,false,false){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    out.template Get<OUT_POS>() = cur.template Get<STA_qIJ>().inverse().toRotationMatrix()*(
-        cur.template Get<STA_IrIB>() - cur.template Get<STA_IrIJ>()
-       + cur.template Get<STA_qIB>().toRotationMatrix()*cur.template Get<STA_BrBV>()) - meas_->GetPos();
+    const Mat<3,3,S> mJI = this->template GetRotationMatrix<1,STA_qIJ>(cur).transpose();
+    const Mat<3,3,S> mIB = this->template GetRotationMatrix<1,STA_qIB>(cur);
+    out.template Get<OUT_POS>() = mJI*(cur.template Get<STA_IrIB>() - cur.template Get<STA_IrIJ>() + mIB*cur.template Get<STA_BrBV>())
+        - meas_->GetPos().template cast<S>();
     return 0;
   }
   int JacPre(MatRefX /*J*/, const typename Previous::CRef /*pre*/, const typename Current::CRef /*cur*/){
     return 0;
   }
   int JacCur(MatRefX J, const typename Previous::CRef /*pre*/, const typename Current::CRef cur){
-    const Vec3 pos = cur.template Get<STA_qIJ>().inverse().toRotationMatrix()*(
-        cur.template Get<STA_IrIB>() - cur.template Get<STA_IrIJ>()
-       + cur.template Get<STA_qIB>().toRotationMatrix()*cur.template Get<STA_BrBV>());
-    const Mat3 mJI =  cur.template Get<STA_qIJ>().inverse().toRotationMatrix();
-    const Mat3 mIB =  cur.template Get<STA_qIB>().toRotationMatrix();
+    const Mat<3,3,S> mJI = this->template GetRotationMatrix<1,STA_qIJ>(cur).transpose();
+    const Mat<3,3,S> mIB = this->template GetRotationMatrix<1,STA_qIB>(cur);
+    const Vec<3,S> pos = mJI*(cur.template Get<STA_IrIB>() - cur.template Get<STA_IrIJ>() + mIB*cur.template Get<STA_BrBV>());
     this->template SetJacCur<OUT_POS,STA_IrIB>(J,cur,mJI);
     this->template SetJacCur<OUT_POS,STA_qIB>(J,cur,-mJI*SSM(mIB*cur.template Get<STA_BrBV>()));
     this->template SetJacCur<OUT_POS,STA_IrIJ>(J,cur,-mJI);
@@ -7,21 +7,31 @@
 namespace tsif{
 
 template<typename... Elements>
-using RandomWalkBase = Residual<ElementVector<Element<Vec<Elements::kDim>,Elements::kI>...>,
-                                ElementVector<Elements...>,
-                                ElementVector<Elements...>,
-                                MeasEmpty>;
+class RandomWalk;
+
+template<typename... Elements>
+using RandomWalkBase = ResidualBase<RandomWalk<Elements...>,
+                                    ElementVector<Element<Vec<Elements::kDim,typename Elements::Scalar>,Elements::kI>...>,
+                                    ElementVector<Elements...>,
+                                    ElementVector<Elements...>,
+                                    MeasEmpty>;
 
 template<typename... Elements>
 class RandomWalk: public RandomWalkBase<Elements...>{
  public:
   typedef ElementVector<Elements...> MyElementVector;
   typedef RandomWalkBase<Elements...> Base;
+  using typename Base::MatRefX;
   using Base::dt_;
   using Base::w_;
   typedef typename Base::Output Output;
   typedef typename Base::Previous Previous;
   typedef typename Base::Current Current;
+  template<typename T>
+  using Rebind = RandomWalk<ElementRebind<Elements,T>...>;
+  // Boxminus of vector and scalar elements has constant Jacobians
+  static constexpr bool kConstantJacobian = ((std::is_arithmetic<typename Elements::Type>::value ||
+      std::is_same<typename Elements::Type,Vec<Elements::kDim,typename Elements::Scalar>>::value) && ...);
   RandomWalk(): Base(true,true,true){}
   int EvalRes(typename Output::Ref out, const typename Previous::CRef pre, const typename Current::CRef cur){
     _EvalRes(out,pre,cur);
@@ -68,7 +78,7 @@ class RandomWalk: public RandomWalkBase<Elements...>{
   int _JacCur(MatRefX /*J*/, const typename Previous::CRef /*pre*/, const typename Current::CRef /*cur*/){
     return 0;
   }
-  virtual double GetWeight(){
+  double GetWeight(){
     return w_/sqrt(dt_);
   }
 };
@@ -9,64 +9,84 @@ namespace tsif{
 template<typename Measurement>
 class Timeline{
  private:
-  std::map<TimePoint,std::shared_ptr<const Measurement>> mm_;
+  typedef std::map<TimePoint,std::shared_ptr<const Measurement>> Map;
+  std::shared_ptr<Map> mm_;  // Shared between copies until one of them is modified (copy-on-write)
+  void Detach(){
+    if(mm_.use_count() > 1){
+      mm_ = std::make_shared<Map>(*mm_);
+    }
+  }
   void RemoveFirst(){
-    if(mm_.size() > 0){
-      mm_.erase(mm_.begin());
+    if(mm_->size() > 0){
+      mm_->erase(mm_->begin());
     }
   }
  public:
   Timeline(Duration max_wait_time,Duration min_wait_time):
-      max_wait_time_(max_wait_time),min_wait_time_(min_wait_time){
+      mm_(std::make_shared<Map>()),max_wait_time_(max_wait_time),min_wait_time_(min_wait_time){
   }
   void Add(TimePoint t,std::shared_ptr<const Measurement> m){
     TSIF_LOG("Add measurement at " << tsif::Print(t));
-    TSIF_LOGWIF(mm_.count(t) > 0, "Entry already exists for measurement!");
-    mm_[t] = m;
+    Detach();
+    TSIF_LOGWIF(mm_->count(t) > 0, "Entry already exists for measurement!");
+    (*mm_)[t] = m;
   }
   bool HasMeas(TimePoint t){
-    return mm_.count(t) > 0;
+    return mm_->count(t) > 0;
   }
   std::shared_ptr<const Measurement> Get(TimePoint t){
-    return mm_.at(t);
+    return mm_->at(t);
+  }
+  /*! \brief Measurement covering the interval which ends at t, i.e. the first one at or after t (as used by Split). Beyond
+   *         the last measurement the last one is held. Returns nullptr if the timeline is empty.
+   */
+  std::shared_ptr<const Measurement> GetCovering(TimePoint t) const{
+    if(mm_->empty()){
+      return nullptr;
+    }
+    auto it = mm_->lower_bound(t);
+    return it == mm_->end() ? mm_->rbegin()->second : it->second;
   }
   void Clean(TimePoint t){
+    if (CountSmallerOrEqual(t) > 1){
+      Detach();
+    }
     while (CountSmallerOrEqual(t) > 1){ // Leave at least one measurement
       RemoveFirst();
     }
   }
   void Clear(){
-    mm_.clear();
+    mm_ = std::make_shared<Map>();
   }
   int CountSmallerOrEqual(TimePoint t){
     int count = 0;
-    auto it = mm_.upper_bound(t);
-    while(it != mm_.begin()){
+    auto it = mm_->upper_bound(t);
+    while(it != mm_->begin()){
       count++;
       it--;
     }
     return count;
   }
   TimePoint GetLastTime() const{
-    if(mm_.empty()){
+    if(mm_->empty()){
       return TimePoint::min();
     } else{
-      return mm_.rbegin()->first;
+      return mm_->rbegin()->first;
     }
   }
   TimePoint GetFirstTime() const{
-    if(mm_.empty()){
+    if(mm_->empty()){
       return TimePoint::max();
     } else{
-      return mm_.begin()->first;
+      return mm_->begin()->first;
     }
   }
   TimePoint GetMaximalUpdateTime(TimePoint current) const{
     return std::max(current-max_wait_time_,GetLastTime()+min_wait_time_);
   }
   void GetAllInRange(std::set<TimePoint>& times, TimePoint start, TimePoint end) const{
-    auto it = mm_.upper_bound(start);
-    while (it != mm_.end() && it->first <= end){
+    auto it = mm_->upper_bound(start);
+    while (it != mm_->end() && it->first <= end){
       times.insert(it->first);
       ++it;
     }
@@ -75,50 +95,53 @@ class Timeline{
   void Split(TimePoint t0, TimePoint t1, TimePoint t2, const Residual& res){
     assert(t0 <= t1 && t1 <= t2);
     TSIF_LOG("Split measurement at " << tsif::Print(t1));
+    Detach();
     Add(t1,std::make_shared<Measurement>());
-    res.SplitMeasurements(t0, t1, t2, mm_.at(t0), mm_.at(t1), mm_.at(t2));
+    res.SplitMeasurements(t0, t1, t2, mm_->at(t0), mm_->at(t1), mm_->at(t2));
   }
   template<typename Residual>
   void Merge(TimePoint t0, TimePoint t1, TimePoint t2, const Residual& res){
     assert(t0 <= t1 && t1 <= t2);
     TSIF_LOG("Merging measurement at " << tsif::Print(t1));
-    res.MergeMeasurements(t0, t1, t2, mm_.at(t0), mm_.at(t1), mm_.at(t2));
-    mm_.erase(t1);
+    Detach();
+    res.MergeMeasurements(t0, t1, t2, mm_->at(t0), mm_->at(t1), mm_->at(t2));
+    mm_->erase(t1);
   }
   template<typename Residual>
   void SplitAndMerge(TimePoint t0, const std::set<TimePoint>& times,const Residual& res){
     if (times.size() == 0){
       return;
     }
+    Detach();
     if (res.isSplitable_){
       for (const auto& t : times){
-        auto it = mm_.lower_bound(t);
-        if (it == mm_.end()){
+        auto it = mm_->lower_bound(t);
+        if (it == mm_->end()){
           TSIF_LOGW("Partial splitting only!");
           break;
         }
         if (it->first == t){
           continue; // Measurement already available
         }
-        assert(it != mm_.begin());
+        assert(it != mm_->begin());
         TimePoint previous = std::prev(it)->first;
         Split(previous, t, it->first, res);
       }
     }
     if (res.isMergeable_){
-      for (auto it = mm_.begin(); it != mm_.end();){
-        if (it->first <= t0 || times.count(it->first) > 0){
+      for (auto it = mm_->upper_bound(t0); it != mm_->end();){
+        if (times.count(it->first) > 0){
           ++it;
-          continue; // Ignore the first or if in times
+          continue; // Ignore if in times
         }
         if (it->first > *times.rbegin()){
           break; // Ignore the last
         }
-        if (std::next(it) == mm_.end()){
+        if (std::next(it) == mm_->end()){
           TSIF_LOGW("Partial merging only!");
           break;
         }
-        assert(it != mm_.begin());
+        assert(it != mm_->begin());
         TimePoint previous = std::prev(it)->first;
         ++it;  // Needs to be increment before erase
         Merge(previous, std::prev(it)->first, it->first, res);
@@ -128,10 +151,10 @@ class Timeline{
 
   std::string Print(const TimePoint& start, int start_offset, double resolution) const{
     std::ostringstream out;
-    const int width = mm_.empty() ? start_offset : start_offset
-                      + std::max(0,(int)(std::ceil(toSec(mm_.rbegin()->first - start) / resolution)) + 1);
+    const int width = mm_->empty() ? start_offset : start_offset
+                      + std::max(0,(int)(std::ceil(toSec(mm_->rbegin()->first - start) / resolution)) + 1);
     std::vector<int> counts(width, 0);
-    for (auto it = mm_.begin(); it != mm_.end(); ++it){
+    for (auto it = mm_->begin(); it != mm_->end(); ++it){
       const int x = start_offset + ceil(toSec(it->first - start) / resolution);
       if (x >= 0){
         counts.at(x)++;
@@ -174,6 +197,9 @@ class Timeline<MeasEmpty>{
   std::shared_ptr<const MeasEmpty> Get(TimePoint /*t*/){
     return std::make_shared<MeasEmpty>();
   }
+  std::shared_ptr<const MeasEmpty> GetCovering(TimePoint /*t*/) const{
+    return std::make_shared<MeasEmpty>();
+  }
   void Clean(TimePoint /*t*/){
   }
   void Clear(){
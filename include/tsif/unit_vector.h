@@ -5,77 +5,82 @@
 
 namespace tsif{
 
-class UnitVector{
+template<typename S>
+class UnitVectorT{
  private:
-  Quat q_;
+  QuatT<S> q_;
  public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
-  UnitVector(){}
-  UnitVector(const UnitVector& other): q_(other.GetQuat()){}
-  UnitVector(const Quat& q): q_(q){}
-  UnitVector(const Vec3& v){
+  typedef S Scalar;
+  UnitVectorT(){}
+  UnitVectorT(const UnitVectorT& other): q_(other.GetQuat()){}
+  UnitVectorT(const QuatT<S>& q): q_(q){}
+  UnitVectorT(const Vec<3,S>& v){
     SetFromVector(v);
   }
-  const Quat& GetQuat() const{
+  UnitVectorT& operator=(const UnitVectorT& other) = default;
+  const QuatT<S>& GetQuat() const{
     return q_;
   }
-  void SetQuat(const Quat& q){
+  void SetQuat(const QuatT<S>& q){
     q_ = q;
   }
-  Vec3 GetVec() const{
-    return q_.toRotationMatrix()*Vec3(0,0,1);
+  Vec<3,S> GetVec() const{
+    return q_.toRotationMatrix()*Vec<3,S>(0,0,1);
   }
-  Vec3 GetPerp1() const{
-    return q_.toRotationMatrix()*Vec3(1,0,0);
+  Vec<3,S> GetPerp1() const{
+    return q_.toRotationMatrix()*Vec<3,S>(1,0,0);
   }
-  Vec3 GetPerp2() const{
-    return q_.toRotationMatrix()*Vec3(0,1,0);
+  Vec<3,S> GetPerp2() const{
+    return q_.toRotationMatrix()*Vec<3,S>(0,1,0);
   }
-  void SetFromVector(const Vec3& vec){
-    q_ = vec.norm() < 1e-12 ? Quat::Identity() : Quat::FromTwoVectors(Vec3(0,0,1),vec);
+  void SetFromVector(const Vec<3,S>& vec){
+    q_ = vec.norm() < 1e-12 ? QuatT<S>::Identity() : QuatT<S>::FromTwoVectors(Vec<3,S>(0,0,1),vec);
   }
   void SetIdentity(){
     q_.setIdentity();
   }
   void SetRandom(){
-    SetFromVector(NormalRandomNumberGenerator::Instance().GetVec<3>());
+    SetFromVector(NormalRandomNumberGenerator::Instance().GetVec<3>().template cast<S>());
   }
-  Eigen::Matrix<double,3,2> GetM() const {
-    Eigen::Matrix<double,3,2> M;
+  Mat<3,2,S> GetM() const {
+    Mat<3,2,S> M;
     M.col(0) = -GetPerp2();
     M.col(1) = GetPerp1();
     return M;
   }
-  Eigen::Matrix<double,3,2> GetN() const {
-    Eigen::Matrix<double,3,2> M;
+  Mat<3,2,S> GetN() const {
+    Mat<3,2,S> M;
     M.col(0) = GetPerp1();
     M.col(1) = GetPerp2();
     return M;
   }
-  void Boxplus(const VecCRef<2>& dif, UnitVector& out) const{
+  void Boxplus(const VecCRef<2,S>& dif, UnitVectorT& out) const{
     out.SetQuat(Exp(dif(0)*GetPerp1()+dif(1)*GetPerp2())*q_);
   }
-  void Boxminus(const UnitVector& ref, VecRef<2> dif) const{
-    dif = ref.GetN().transpose()*Log(Quat::FromTwoVectors(ref.GetVec(),GetVec()));
+  void Boxminus(const UnitVectorT& ref, VecRef<2,S> dif) const{
+    dif = ref.GetN().transpose()*Log(QuatT<S>::FromTwoVectors(ref.GetVec(),GetVec()));
   }
-  void BoxminusJacRef(const UnitVector& ref, MatRef<2> J) const{
+  void BoxminusJacRef(const UnitVectorT& ref, MatRef<2,2,S> J) const{
     J = ref.GetN().transpose()*FromTwoVectorsJac(ref.GetVec(),GetVec())*ref.GetM();
   }
-  void BoxminusJacInp(const UnitVector& ref, MatRef<2> J) const{
+  void BoxminusJacInp(const UnitVectorT& ref, MatRef<2,2,S> J) const{
     J = -ref.GetN().transpose()*FromTwoVectorsJac(GetVec(),ref.GetVec())*GetM();
   }
-  void BoxplusJacVec(const VecCRef<2>& dif, MatRef<2> J) const{
-    UnitVector out;
+  void BoxplusJacVec(const VecCRef<2,S>& dif, MatRef<2,2,S> J) const{
+    UnitVectorT out;
     Boxplus(dif,out);
     J = out.GetN().transpose()*GammaMat(dif(0)*GetPerp1()+dif(1)*GetPerp2())*GetN();
   }
-  void BoxplusJacInp(const VecCRef<2>& dif, MatRef<2> J) const{
-    UnitVector out;
+  void BoxplusJacInp(const VecCRef<2,S>& dif, MatRef<2,2,S> J) const{
+    UnitVectorT out;
     Boxplus(dif,out);
     J = out.GetN().transpose()*GetN();
   }
 };
 
+typedef UnitVectorT<double> UnitVector;
+
 } // namespace tsif
 
 #endif  // TSIF_UNIT_VECTOR_H_
@@ -0,0 +1,73 @@
+#ifndef TSIF_BACKGROUND_WORKER_HPP_
+#define TSIF_BACKGROUND_WORKER_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace tsif{
+
+/*! \brief Background Worker
+ *         Single thread executing posted jobs in order, used to overlap a cheap preparation with work on the calling
+ *         thread. Wait() returns once all jobs posted so far have finished.
+ */
+class BackgroundWorker{
+ public:
+  BackgroundWorker(){
+    stop_ = false;
+    busy_ = false;
+    thread_ = std::thread(&BackgroundWorker::Loop,this);
+  }
+  ~BackgroundWorker(){
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+  BackgroundWorker(const BackgroundWorker&) = delete;
+  BackgroundWorker& operator=(const BackgroundWorker&) = delete;
+  void Post(std::function<void()> job){
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    cv_.notify_all();
+  }
+  void Wait(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock,[this](){ return jobs_.empty() && !busy_; });
+  }
+
+ private:
+  void Loop(){
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true){
+      cv_.wait(lock,[this](){ return stop_ || !jobs_.empty(); });
+      if(jobs_.empty()){
+        return;  // Stopped and drained
+      }
+      std::function<void()> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      busy_ = true;
+      lock.unlock();
+      job();
+      lock.lock();
+      busy_ = false;
+      cv_.notify_all();
+    }
+  }
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> jobs_;
+  bool stop_;
+  bool busy_;
+  std::thread thread_;
+};
+
+} // namespace tsif
+
+#endif /* TSIF_BACKGROUND_WORKER_HPP_ */
@@ -0,0 +1,172 @@
+#ifndef TSIF_BATCH_DENSE_HPP_
+#define TSIF_BATCH_DENSE_HPP_
+
+#include <cmath>
+#include <vector>
+
+#include "tsif/utils/typedefs.h"
+
+namespace tsif{
+
+/*! \brief Batch Matrix
+ *         K matrices of equal size in structure-of-arrays form: the K lanes of every coefficient are contiguous, such
+ *         that the batched kernels below operate on all lanes with the innermost (vectorizable) loop. Every lane
+ *         performs exactly the operations of the same kernel on a single matrix.
+ */
+template<typename S = double>
+class BatchMatrix{
+ public:
+  BatchMatrix(int rows = 0, int cols = 0, int lanes = 0){
+    Resize(rows,cols,lanes);
+  }
+  void Resize(int rows, int cols, int lanes){
+    rows_ = rows;
+    cols_ = cols;
+    lanes_ = lanes;
+    data_.resize(static_cast<size_t>(rows)*cols*lanes);
+  }
+  int rows() const{
+    return rows_;
+  }
+  int cols() const{
+    return cols_;
+  }
+  int lanes() const{
+    return lanes_;
+  }
+  S* operator()(int i, int j){
+    return data_.data() + (static_cast<size_t>(j)*rows_+i)*lanes_;
+  }
+  const S* operator()(int i, int j) const{
+    return data_.data() + (static_cast<size_t>(j)*rows_+i)*lanes_;
+  }
+  template<typename Derived>
+  void SetLane(int l, const Eigen::MatrixBase<Derived>& m){
+    for(int j=0;j<cols_;j++){
+      for(int i=0;i<rows_;i++){
+        (*this)(i,j)[l] = m(i,j);
+      }
+    }
+  }
+  template<typename Derived>
+  void GetLane(int l, Eigen::MatrixBase<Derived>& m) const{
+    for(int j=0;j<cols_;j++){
+      for(int i=0;i<rows_;i++){
+        m(i,j) = (*this)(i,j)[l];
+      }
+    }
+  }
+
+ private:
+  int rows_;
+  int cols_;
+  int lanes_;
+  std::vector<S> data_;
+};
+
+/*! \brief In-place Cholesky factorization A = L * L^T of every lane (lower triangle, the upper triangle is not
+ *         referenced). ok[l] is set to false if lane l is not positive definite (its result is then undefined).
+ */
+template<typename S>
+void BatchLLT(BatchMatrix<S>& A, std::vector<char>& ok){
+  const int n = A.rows();
+  const int K = A.lanes();
+  ok.assign(K,1);
+  for(int j=0;j<n;j++){
+    S* Ajj = A(j,j);
+    for(int k=0;k<j;k++){
+      const S* Ajk = A(j,k);
+      for(int l=0;l<K;l++){
+        Ajj[l] -= Ajk[l]*Ajk[l];
+      }
+    }
+    for(int l=0;l<K;l++){
+      ok[l] &= Ajj[l] > S(0);
+      Ajj[l] = std::sqrt(Ajj[l] > S(0) ? Ajj[l] : S(1));
+    }
+    for(int i=j+1;i<n;i++){
+      S* Aij = A(i,j);
+      for(int k=0;k<j;k++){
+        const S* Aik = A(i,k);
+        const S* Ajk = A(j,k);
+        for(int l=0;l<K;l++){
+          Aij[l] -= Aik[l]*Ajk[l];
+        }
+      }
+      for(int l=0;l<K;l++){
+        Aij[l] /= Ajj[l];
+      }
+    }
+  }
+}
+
+/*! \brief B = L^-1 * B for lower triangular L (forward substitution).
+ */
+template<typename S>
+void BatchLowerSolve(const BatchMatrix<S>& L, BatchMatrix<S>& B){
+  const int n = L.rows();
+  const int K = L.lanes();
+  for(int c=0;c<B.cols();c++){
+    for(int i=0;i<n;i++){
+      S* Bi = B(i,c);
+      for(int k=0;k<i;k++){
+        const S* Lik = L(i,k);
+        const S* Bk = B(k,c);
+        for(int l=0;l<K;l++){
+          Bi[l] -= Lik[l]*Bk[l];
+        }
+      }
+      const S* Lii = L(i,i);
+      for(int l=0;l<K;l++){
+        Bi[l] /= Lii[l];
+      }
+    }
+  }
+}
+
+/*! \brief B = L^-T * B for lower triangular L (backward substitution).
+ */
+template<typename S>
+void BatchLowerTransposeSolve(const BatchMatrix<S>& L, BatchMatrix<S>& B){
+  const int n = L.rows();
+  const int K = L.lanes();
+  for(int c=0;c<B.cols();c++){
+    for(int i=n-1;i>=0;i--){
+      S* Bi = B(i,c);
+      for(int k=i+1;k<n;k++){
+        const S* Lki = L(k,i);
+        const S* Bk = B(k,c);
+        for(int l=0;l<K;l++){
+          Bi[l] -= Lki[l]*Bk[l];
+        }
+      }
+      const S* Lii = L(i,i);
+      for(int l=0;l<K;l++){
+        Bi[l] /= Lii[l];
+      }
+    }
+  }
+}
+
+/*! \brief C -= A^T * B.
+ */
+template<typename S>
+void BatchSubtractTransposeProduct(const BatchMatrix<S>& A, const BatchMatrix<S>& B, BatchMatrix<S>& C){
+  const int K = A.lanes();
+  for(int j=0;j<C.cols();j++){
+    for(int i=0;i<C.rows();i++){
+      S* Cij = C(i,j);
+      for(int k=0;k<A.rows();k++){
+        const S* Aki = A(k,i);
+        const S* Bkj = B(k,j);
+        for(int l=0;l<K;l++){
+          Cij[l] -= Aki[l]*Bkj[l];
+        }
+      }
+    }
+  }
+}
+
+} // namespace tsif
+
+#endif /* TSIF_BATCH_DENSE_HPP_ */
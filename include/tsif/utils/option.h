@@ -39,9 +39,9 @@ struct OptionLoaderTraits<double>{
     return true;
   }
 };
-template<int N>
-struct OptionLoaderTraits<Vec<N>>{
-  static bool Get(Vec<N>& x, const std::vector<std::string>& data){
+template<int N, typename S>
+struct OptionLoaderTraits<Vec<N,S>>{
+  static bool Get(Vec<N,S>& x, const std::vector<std::string>& data){
     assert(data.size() == N);
     for(int i=0;i<N;i++){
       x(i) = stod(data[i]);
@@ -49,9 +49,9 @@ struct OptionLoaderTraits<Vec<N>>{
     return true;
   }
 };
-template<>
-struct OptionLoaderTraits<Quat>{
-  static bool Get(Quat& x, const std::vector<std::string>& data){
+template<typename S>
+struct OptionLoaderTraits<QuatT<S>>{
+  static bool Get(QuatT<S>& x, const std::vector<std::string>& data){
     assert(data.size() == 4);
     x.w() = stod(data[0]);
     x.x() = stod(data[1]);
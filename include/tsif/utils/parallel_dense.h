@@ -0,0 +1,99 @@
+#ifndef TSIF_PARALLEL_DENSE_HPP_
+#define TSIF_PARALLEL_DENSE_HPP_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tsif/utils/thread_pool.h"
+#include "tsif/utils/typedefs.h"
+
+namespace tsif{
+
+/*! \brief Blocked dense kernels for the update of large states. The matrices are cut into blockSize x blockSize tiles
+ *         and independent tiles are distributed on a ThreadPool. Each tile is computed by Eigen, i.e. the result only
+ *         differs from the unblocked kernels by the summation order.
+ */
+static constexpr int kParallelDenseBlockSize = 64;
+
+/*! \brief Lower triangular tile pairs (i,j), i >= j, of nb x nb tiles.
+ */
+inline std::vector<std::pair<int,int>> LowerTiles(int nb){
+  std::vector<std::pair<int,int>> tiles;
+  for(int j=0;j<nb;j++){
+    for(int i=j;i<nb;i++){
+      tiles.emplace_back(i,j);
+    }
+  }
+  return tiles;
+}
+
+/*! \brief C -= Y^T * Y (symmetric rank-k update). Only the lower tiles are computed, the upper triangle is mirrored.
+ */
+template<typename S>
+void ParallelSubtractGram(ThreadPool& pool, const Mat<-1,-1,S>& Y, Mat<-1,-1,S>& C, int blockSize = kParallelDenseBlockSize){
+  const int n = C.rows();
+  const int nb = (n+blockSize-1)/blockSize;
+  const std::vector<std::pair<int,int>> tiles = LowerTiles(nb);
+  pool.ParallelFor(tiles.size(),[&](int t){
+    const int i = tiles[t].first*blockSize;
+    const int j = tiles[t].second*blockSize;
+    const int ni = std::min(blockSize,n-i);
+    const int nj = std::min(blockSize,n-j);
+    C.block(i,j,ni,nj).noalias() -= Y.middleCols(i,ni).transpose()*Y.middleCols(j,nj);
+  });
+  C.template triangularView<Eigen::StrictlyUpper>() = C.transpose();
+}
+
+/*! \brief B = L^-1 * B for a lower triangular L, solved independently on column tiles of B.
+ */
+template<typename S>
+void ParallelLowerSolve(ThreadPool& pool, const Mat<-1,-1,S>& L, Mat<-1,-1,S>& B, int blockSize = kParallelDenseBlockSize){
+  const int m = B.cols();
+  pool.ParallelFor((m+blockSize-1)/blockSize,[&](int t){
+    auto Bt = B.middleCols(t*blockSize,std::min(blockSize,m-t*blockSize));
+    L.template triangularView<Eigen::Lower>().solveInPlace(Bt);
+  });
+}
+
+/*! \brief In-place blocked right-looking Cholesky factorization A = L * L^T, the strictly upper part is zeroed. Panel
+ *         solves and trailing updates run in parallel. Returns false if A is not positive definite.
+ */
+template<typename S>
+bool ParallelLLT(ThreadPool& pool, Mat<-1,-1,S>& A, int blockSize = kParallelDenseBlockSize){
+  const int n = A.rows();
+  for(int k=0;k<n;k+=blockSize){
+    const int kb = std::min(blockSize,n-k);
+    Eigen::LLT<Mat<-1,-1,S>> llt(A.block(k,k,kb,kb));
+    if(llt.info() != Eigen::Success){
+      return false;
+    }
+    A.block(k,k,kb,kb) = llt.matrixL();
+    const int r = k+kb;
+    const int m = n-r;
+    if(m == 0){
+      break;
+    }
+    const int nb = (m+blockSize-1)/blockSize;
+    // Panel: A21 = A21 * L11^-T
+    pool.ParallelFor(nb,[&](int t){
+      auto A21 = A.block(r+t*blockSize,k,std::min(blockSize,m-t*blockSize),kb);
+      A.block(k,k,kb,kb).transpose().template triangularView<Eigen::Upper>().template solveInPlace<Eigen::OnTheRight>(A21);
+    });
+    // Trailing update: A22 -= A21 * A21^T (lower tiles)
+    const std::vector<std::pair<int,int>> tiles = LowerTiles(nb);
+    pool.ParallelFor(tiles.size(),[&](int t){
+      const int i = r+tiles[t].first*blockSize;
+      const int j = r+tiles[t].second*blockSize;
+      const int ni = std::min(blockSize,n-i);
+      const int nj = std::min(blockSize,n-j);
+      A.block(i,j,ni,nj).noalias() -= A.block(i,k,ni,kb)*A.block(j,k,nj,kb).transpose();
+    });
+  }
+  A.template triangularView<Eigen::StrictlyUpper>().setZero();
+  return true;
+}
+
+} // namespace tsif
+
+#endif /* TSIF_PARALLEL_DENSE_HPP_ */
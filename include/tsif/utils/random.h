@@ -1,42 +1,241 @@
 #ifndef TSIF_RANDOM_HPP_
 #define TSIF_RANDOM_HPP_
 
+#include "tsif/utils/thread_pool.h"
 #include "tsif/utils/typedefs.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <random>
 
 namespace tsif{
 
+/*! \brief Philox Normal Generator
+ *         Counter-based generator of normal random numbers (N(0,1)). The k-th number of a stream is a pure function of
+ *         (seed, stream, k): the Philox4x32-10 block of the counter (k/4, stream) keyed with the seed is mapped to four
+ *         normals by Box-Muller. Generators are therefore cheap to split (one stream per thread, filter instance or
+ *         Monte Carlo run) and the results do not depend on how the draws are distributed among threads. Blocks are
+ *         generated in batches of kBatch with the lanes in the innermost loops (vectorizable), such that GetVec and
+ *         Fill on large vectors are considerably faster than repeated Get().
+ */
+class PhiloxNormalGenerator{
+ public:
+  typedef std::array<uint32_t,4> Counter;
+  typedef std::array<uint32_t,2> Key;
+  static constexpr int kBatch = 16;
+
+  explicit PhiloxNormalGenerator(uint64_t seed = 0, uint64_t stream = 0){
+    Seed(seed,stream);
+  }
+  void Seed(uint64_t seed, uint64_t stream = 0){
+    seed_ = seed;
+    stream_ = stream;
+    index_ = 0;
+    cachedBegin_ = 0;
+    cachedEnd_ = 0;
+  }
+  /*! \brief Independent generator with the same seed, e.g. for the stream of a thread or filter instance.
+   */
+  PhiloxNormalGenerator Split(uint64_t stream) const{
+    return PhiloxNormalGenerator(seed_,stream);
+  }
+  uint64_t GetSeed() const{
+    return seed_;
+  }
+  uint64_t GetStream() const{
+    return stream_;
+  }
+  /*! \brief Position within the stream (number of normals drawn so far), can be set to skip ahead.
+   */
+  uint64_t GetIndex() const{
+    return index_;
+  }
+  void SetIndex(uint64_t index){
+    index_ = index;
+  }
+  double Get(){
+    if(index_ >= cachedBegin_ && index_ < cachedEnd_){
+      return cached_[index_++-cachedBegin_];
+    }
+    double x;
+    Fill(&x,1);
+    return x;
+  }
+  template<int N>
+  Vec<N> GetVec(){
+    Vec<N> n;
+    Fill(n.data(),N);
+    return n;
+  }
+  void Fill(double* out, int n){
+    while(n > 0){
+      const uint64_t block = index_/4;
+      const int offset = index_%4;
+      if(offset == 0 && n >= 4){
+        const int count = std::min(n/4,kBatch);
+        GenerateBlocks(block,count,out);
+        out += 4*count;
+        n -= 4*count;
+        index_ += 4*count;
+      } else {  // Short draws are served from a cached batch
+        if(index_ < cachedBegin_ || index_ >= cachedEnd_){
+          GenerateBlocks(block,kBatch,cached_.data());
+          cachedBegin_ = 4*block;
+          cachedEnd_ = cachedBegin_+4*kBatch;
+        }
+        const int begin = index_-cachedBegin_;
+        const int count = std::min<uint64_t>(n,cachedEnd_-index_);
+        std::copy(cached_.begin()+begin,cached_.begin()+begin+count,out);
+        out += count;
+        n -= count;
+        index_ += count;
+      }
+    }
+  }
+
+  /*! \brief The Philox4x32-10 bijection.
+   */
+  static Counter Philox(Counter c, Key k){
+    for(int r=0;r<10;r++){
+      if(r > 0){
+        k[0] += kW0;
+        k[1] += kW1;
+      }
+      const uint64_t p0 = uint64_t(kM0)*c[0];
+      const uint64_t p1 = uint64_t(kM1)*c[2];
+      c = {uint32_t(p1 >> 32) ^ c[1] ^ k[0], uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k[1], uint32_t(p0)};
+    }
+    return c;
+  }
+
+ private:
+  // Writes the normals of count <= kBatch consecutive blocks to out
+  void GenerateBlocks(uint64_t block, int count, double* out) const{
+    uint32_t c0[kBatch], c1[kBatch], c2[kBatch], c3[kBatch];
+    for(int l=0;l<count;l++){
+      c0[l] = uint32_t(block+l);
+      c1[l] = uint32_t((block+l) >> 32);
+      c2[l] = uint32_t(stream_);
+      c3[l] = uint32_t(stream_ >> 32);
+    }
+    uint32_t k0 = uint32_t(seed_);
+    uint32_t k1 = uint32_t(seed_ >> 32);
+    for(int r=0;r<10;r++){
+      if(r > 0){
+        k0 += kW0;
+        k1 += kW1;
+      }
+      for(int l=0;l<count;l++){
+        const uint64_t p0 = uint64_t(kM0)*c0[l];
+        const uint64_t p1 = uint64_t(kM1)*c2[l];
+        c0[l] = uint32_t(p1 >> 32) ^ c1[l] ^ k0;
+        c1[l] = uint32_t(p1);
+        c2[l] = uint32_t(p0 >> 32) ^ c3[l] ^ k1;
+        c3[l] = uint32_t(p0);
+      }
+    }
+    for(int l=0;l<count;l++){
+      BoxMuller(c0[l],c1[l],out+4*l);
+      BoxMuller(c2[l],c3[l],out+4*l+2);
+    }
+  }
+  static void BoxMuller(uint32_t a, uint32_t b, double* out){
+    constexpr double kScale = 1.0/4294967296.0;
+    const double r = std::sqrt(-2.0*std::log((a+0.5)*kScale));  // Uniform in (0,1)
+    const double theta = 2.0*M_PI*b*kScale;
+    out[0] = r*std::cos(theta);
+    out[1] = r*std::sin(theta);
+  }
+
+  static constexpr uint32_t kM0 = 0xD2511F53;
+  static constexpr uint32_t kM1 = 0xCD9E8D57;
+  static constexpr uint32_t kW0 = 0x9E3779B9;
+  static constexpr uint32_t kW1 = 0xBB67AE85;
+  uint64_t seed_;
+  uint64_t stream_;
+  uint64_t index_;
+  uint64_t cachedBegin_;  // Range of the cached normals
+  uint64_t cachedEnd_;
+  std::array<double,4*kBatch> cached_;
+};
+
 /*! \brief Normal Random Number Generator
- *         Singleton class for generating normal random numbers (N(0,1)). Allows setting of seed.
+ *         Per-thread generator for normal random numbers (N(0,1)), used by the SetRandom methods. Every thread has its
+ *         own instance, by default drawing from stream 0 of the process-wide seed (SetSeed, 0 by default), which the
+ *         instances of all threads pick up on their next draw. The draws of a thread thus never depend on the order in
+ *         which threads start. Threads drawing concurrently select their own stream (SetStream), which is mandatory
+ *         within the tasks of a ThreadPool (asserted), such that the draws do not depend on the number of threads.
  */
 class NormalRandomNumberGenerator{
  public:
+  /*! \brief Seeds the generators of all threads, each one restarts the default stream.
+   */
   void SetSeed(int s){
-    generator_.seed(s);
+    seed_.store(s);
+    seedEpoch_.fetch_add(1);
+    Sync();
+  }
+  /*! \brief Selects seed and stream of the calling thread until the next SetSeed.
+   */
+  void SetStream(uint64_t seed, uint64_t stream){
+    Sync();
+    Seed(seed,stream);
+    isStreamSelected_ = true;
   }
   double Get(){
-    return distribution_(generator_);
+    SyncDraw();
+    return philox_.Get();
   }
   template<int N>
   Vec<N> GetVec(){
-    Vec<N> n;
-    for(int i=0;i<N;i++){
-      n(i) = Get();
-    }
-    return n;
+    SyncDraw();
+    return philox_.GetVec<N>();
   }
   static NormalRandomNumberGenerator& Instance(){
-    static NormalRandomNumberGenerator instance;
+    static thread_local NormalRandomNumberGenerator instance;
     return instance;
   }
+  PhiloxNormalGenerator& GetPhilox(){
+    SyncDraw();
+    return philox_;
+  }
   std::default_random_engine& GetGenerator(){
+    SyncDraw();
     return generator_;
   }
  protected:
+  PhiloxNormalGenerator philox_;
   std::default_random_engine generator_;
-  std::normal_distribution<double> distribution_;
-  NormalRandomNumberGenerator(): generator_(0), distribution_(0.0,1.0){
+  uint64_t epoch_;          // Value of seedEpoch_ the instance has been seeded with
+  bool isStreamSelected_;   // Has SetStream been called since the last seeding
+  inline static std::atomic<uint64_t> seed_{0};
+  inline static std::atomic<uint64_t> seedEpoch_{0};
+  NormalRandomNumberGenerator(){
+    Reseed();
+  }
+  void Sync(){
+    if(epoch_ != seedEpoch_.load(std::memory_order_acquire)){
+      Reseed();
+    }
+  }
+  // Before every draw, the default stream would make the draws of a task depend on the thread it runs on
+  void SyncDraw(){
+    Sync();
+    assert((isStreamSelected_ || !ThreadPool::IsInTask()) && "Select a stream (SetStream) in parallel tasks");
+  }
+  void Reseed(){
+    epoch_ = seedEpoch_.load(std::memory_order_acquire);
+    Seed(seed_.load(),0);
+    isStreamSelected_ = false;
+  }
+  void Seed(uint64_t seed, uint64_t stream){
+    philox_.Seed(seed,stream);
+    std::seed_seq seq{uint32_t(seed),uint32_t(seed >> 32),uint32_t(stream),uint32_t(stream >> 32)};
+    generator_.seed(seq);
   }
 };
 
@@ -6,67 +6,258 @@
 
 namespace tsif{
 
+/*! \brief Rotation Coefficients
+ *         Scalar coefficients of the closed-form SO(3) kernels as functions of the squared rotation
+ *         angle t2. Below kSmallAngle2 a Taylor expansion is selected instead of the exact
+ *         expression, the exact branch is evaluated on a safe argument so that the selection
+ *         compiles to a conditional move (or blend for the batch variants) and never produces
+ *         NaNs (also not in the derivatives of automatic differentiation scalars).
+ */
+static constexpr double kSmallAngle2 = 1e-4;
+
+template<typename S>
+static S SinOverAngle(const S& t2){  // sin(t)/t
+  using std::sin; using std::sqrt;
+  const bool small = t2 < kSmallAngle2;
+  const S t = sqrt(small ? S(1) : t2);
+  const S series = 1.0 - t2/6.0 + t2*t2/120.0;
+  const S exact = sin(t)/t;
+  return small ? series : exact;
+}
+template<typename S>
+static S OneMinusCosOverAngle2(const S& t2){  // (1-cos(t))/t^2
+  using std::sin; using std::sqrt;
+  const bool small = t2 < kSmallAngle2;
+  const S safe = small ? S(1) : t2;
+  const S sh = sin(0.5*sqrt(safe));
+  const S series = 0.5 - t2/24.0 + t2*t2/720.0;
+  const S exact = 2.0*sh*sh/safe;
+  return small ? series : exact;
+}
+template<typename S>
+static S AngleMinusSinOverAngle3(const S& t2){  // (t-sin(t))/t^3
+  using std::sin; using std::sqrt;
+  const bool small = t2 < kSmallAngle2;
+  const S safe = small ? S(1) : t2;
+  const S t = sqrt(safe);
+  const S series = 1.0/6.0 - t2/120.0 + t2*t2/5040.0;
+  const S exact = (t - sin(t))/(safe*t);
+  return small ? series : exact;
+}
+template<typename S>
+static S GammaInvCoeff(const S& t2){  // (1-(t/2)cot(t/2))/t^2
+  using std::sin; using std::cos; using std::sqrt;
+  const bool small = t2 < kSmallAngle2;
+  const S safe = small ? S(1) : t2;
+  const S h = 0.5*sqrt(safe);
+  const S series = 1.0/12.0 + t2/720.0 + t2*t2/30240.0;
+  const S exact = (1.0 - h*cos(h)/sin(h))/safe;
+  return small ? series : exact;
+}
+template<typename S>
+static S CosHalfAngle(const S& t2){  // cos(t/2)
+  using std::cos; using std::sqrt;
+  const bool small = t2 < kSmallAngle2;
+  const S series = 1.0 - t2/8.0 + t2*t2/384.0;
+  const S exact = cos(0.5*sqrt(small ? S(1) : t2));
+  return small ? series : exact;
+}
+
 static constexpr double Sinc(const double x){
   return fabs(x) < 1e-8 ? 1 : sin(x)/x;
 }
-static Quat Exp(const Vec3& v){
-  const double ha = 0.5*v.norm();
-  const double re = cos(ha);
-  const Vec3 im = 0.5*Sinc(ha)*v;
-  return Quat(re,im(0),im(1),im(2));
+template<typename Derived>
+static QuatT<typename Derived::Scalar> Exp(const Eigen::MatrixBase<Derived>& v){
+  typedef typename Derived::Scalar S;
+  const S t2 = v.squaredNorm();
+  const S f = 0.5*SinOverAngle<S>(0.25*t2);
+  const Vec<3,S> im = f*v;
+  return QuatT<S>(CosHalfAngle<S>(t2),im(0),im(1),im(2));
 }
-static Vec3 Log(const Quat& q){
-  const double re = q.w();
-  const Vec3 im(q.x(),q.y(),q.z());
-  const double sha = im.norm();
-  return sha < 1e-8 ? ((std::signbit(re)!=0)*-2+1)*2*im : 2*atan(sha/re)/sha*im;
+template<typename S>
+static Vec<3,S> Log(const QuatT<S>& q){
+  using std::atan2; using std::sqrt;
+  const S re = q.w();
+  const Vec<3,S> im(q.x(),q.y(),q.z());
+  const S s2 = im.squaredNorm();
+  const bool small = s2 < kSmallAngle2*kSmallAngle2;
+  const S sha = sqrt(small ? S(1) : s2);
+  const S series = 2.0/re*(1.0 - s2/(3.0*re*re));
+  const S exact = 2.0*atan2(S(sha/re),S(1))/sha;  // atan(sha/re), atan2 is also defined for dual numbers
+  return (small ? series : exact)*im;
 }
-static Quat Boxplus(const Quat& q, const Vec3& v){
+template<typename S, typename Derived>
+static QuatT<S> Boxplus(const QuatT<S>& q, const Eigen::MatrixBase<Derived>& v){
   return Exp(v)*q;
 }
-static Vec3 Boxminus(const Quat& q, const Quat& p){
-  return Log(q*p.inverse());
+template<typename S>
+static Vec<3,S> Boxminus(const QuatT<S>& q, const QuatT<S>& p){
+  return Log(QuatT<S>(q*p.inverse()));
 }
-static Mat3 SSM(const Vec3& vec){
-  Mat3 mat;
-  mat << 0, -vec(2), vec(1), vec(2), 0, -vec(0), -vec(1), vec(0), 0;
+template<typename Derived>
+static Mat<3,3,typename Derived::Scalar> SSM(const Eigen::MatrixBase<Derived>& vec){
+  typedef typename Derived::Scalar S;
+  Mat<3,3,S> mat;
+  mat << S(0), -vec(2), vec(1), vec(2), S(0), -vec(0), -vec(1), vec(0), S(0);
   return mat;
 }
-static Mat3 RotMat(const Vec3& vec){
-  const double a = vec.norm();
-  if(a < 1e-8){
-    return Mat3::Identity() + SSM(vec);
-  } else{
-    const Vec3 axis = vec.normalized();
-    return Mat3::Identity() + sin(a)*SSM(axis) + (1-cos(a))*SSM(axis)*SSM(axis);
-  }
+/*! \brief Evaluates I + a*SSM(v) + b*SSM(v)^2 using SSM(v)^2 = v*v^T - |v|^2*I.
+ */
+template<typename S>
+static Mat<3,3,S> SO3Poly(const Vec<3,S>& vec, const S& t2, const S& a, const S& b){
+  Mat<3,3,S> mat = b*vec*vec.transpose() + a*SSM(vec);
+  const S diag = 1.0 - b*t2;
+  mat.diagonal().array() += diag;
+  return mat;
 }
-static Mat3 GammaMat(const Vec3& vec){
-  const double a = vec.norm();
-  if(a < 1e-8){
-    return Mat3::Identity() + 0.5 * SSM(vec);
-  } else{
-    const Vec3 axis = vec.normalized();
-    return Mat3::Identity() + (1-cos(a))/a*SSM(axis) + (a-sin(a))/a*SSM(axis)*SSM(axis);
-  }
+template<typename Derived>
+static Mat<3,3,typename Derived::Scalar> RotMat(const Eigen::MatrixBase<Derived>& v){
+  typedef typename Derived::Scalar S;
+  const Vec<3,S> vec = v;
+  const S t2 = vec.squaredNorm();
+  return SO3Poly<S>(vec, t2, SinOverAngle(t2), OneMinusCosOverAngle2(t2));
+}
+template<typename Derived>
+static Mat<3,3,typename Derived::Scalar> GammaMat(const Eigen::MatrixBase<Derived>& v){
+  typedef typename Derived::Scalar S;
+  const Vec<3,S> vec = v;
+  const S t2 = vec.squaredNorm();
+  return SO3Poly<S>(vec, t2, OneMinusCosOverAngle2(t2), AngleMinusSinOverAngle3(t2));
 }
-static Mat3 FromTwoVectorsJac(const Vec3& a, const Vec3& b){
-  const Vec3 cross = a.cross(b);
-  const double crossNorm = cross.norm();
-  Vec3 crossNormalized = cross/crossNorm;
-  Mat3 crossNormalizedSqew = SSM(crossNormalized);
-  const double c = a.dot(b);
-  const double angle = std::acos(c);
+/*! \brief Closed-form inverse of GammaMat (valid for rotation angles below 2*pi).
+ */
+template<typename Derived>
+static Mat<3,3,typename Derived::Scalar> GammaMatInv(const Eigen::MatrixBase<Derived>& v){
+  typedef typename Derived::Scalar S;
+  const Vec<3,S> vec = v;
+  const S t2 = vec.squaredNorm();
+  return SO3Poly<S>(vec, t2, S(-0.5), GammaInvCoeff(t2));
+}
+template<typename DerivedA, typename DerivedB>
+static Mat<3,3,typename DerivedA::Scalar> FromTwoVectorsJac(const Eigen::MatrixBase<DerivedA>& a, const Eigen::MatrixBase<DerivedB>& b){
+  typedef typename DerivedA::Scalar S;
+  using std::acos;
+  const Vec<3,S> cross = a.cross(b);
+  const S crossNorm = cross.norm();
+  const S c = a.dot(b);
   if(crossNorm<1e-6){
     if(c>0){
       return -SSM(b);
     } else {
       TSIF_LOGW("Warning: instable FromTwoVectorsJac!");
-      return Mat3::Zero();
+      return Mat<3,3,S>::Zero();
     }
   } else {
-    return -1/crossNorm*(crossNormalized*b.transpose()-(crossNormalizedSqew*crossNormalizedSqew*SSM(b)*angle));
+    // SSM(n)^2 = n*n^T - I for the normalized cross product n
+    const Vec<3,S> crossNormalized = cross/crossNorm;
+    const S angle = acos(c);
+    Mat<3,3,S> nnT = crossNormalized*crossNormalized.transpose();
+    nnT.diagonal().array() -= S(1);
+    const S f = -1/crossNorm;
+    return f*(crossNormalized*b.transpose()-(nnT*SSM(b)*angle));
+  }
+}
+
+// ==================== Batch Kernels ==================== //
+/*! \brief Structure-of-arrays storage for batches of small vectors. Row r holds component r of all
+ *         entries contiguously so that the batch kernels vectorize across entries. Quaternions are
+ *         stored with rows (x,y,z,w), 3x3 matrices column-major in rows 0-8.
+ */
+template<int R>
+using BatchMat = Eigen::Matrix<double,R,Eigen::Dynamic,Eigen::RowMajor>;
+using BatchArray = Eigen::Array<double,1,Eigen::Dynamic>;
+
+namespace batch{
+
+static BatchArray SinOverAngle(const BatchArray& t2){
+  const auto small = t2 < kSmallAngle2;
+  const BatchArray t = t2.sqrt();
+  return small.select(1.0 - t2/6.0 + t2*t2/120.0, t.sin()/small.select(1.0,t));
+}
+static BatchArray OneMinusCosOverAngle2(const BatchArray& t2){
+  const auto small = t2 < kSmallAngle2;
+  return small.select(0.5 - t2/24.0 + t2*t2/720.0, 2.0*(0.5*t2.sqrt()).sin().square()/small.select(1.0,t2));
+}
+static BatchArray AngleMinusSinOverAngle3(const BatchArray& t2){
+  const auto small = t2 < kSmallAngle2;
+  const BatchArray t = t2.sqrt();
+  return small.select(1.0/6.0 - t2/120.0 + t2*t2/5040.0, (t - t.sin())/small.select(1.0,t2*t));
+}
+static BatchArray GammaInvCoeff(const BatchArray& t2){
+  const auto small = t2 < kSmallAngle2;
+  const BatchArray h = 0.5*t2.sqrt();
+  return small.select(1.0/12.0 + t2/720.0 + t2*t2/30240.0,
+                      (1.0 - h*h.cos()/small.select(1.0,h.sin()))/small.select(1.0,t2));
+}
+static BatchArray SquaredNorm(const BatchMat<3>& v){
+  return v.row(0).array().square() + v.row(1).array().square() + v.row(2).array().square();
+}
+static void SO3Poly(const BatchMat<3>& v, const BatchArray& t2, const BatchArray& a, const BatchArray& b, BatchMat<9>& out){
+  out.resize(9,v.cols());
+  const BatchArray diag = 1.0 - b*t2;
+  for(int j=0;j<3;j++){
+    for(int i=0;i<3;i++){
+      out.row(3*j+i).array() = b*v.row(i).array()*v.row(j).array();
+    }
+    out.row(4*j).array() += diag;
   }
+  out.row(5).array() += a*v.row(0).array();  // (2,1)
+  out.row(7).array() -= a*v.row(0).array();  // (1,2)
+  out.row(6).array() += a*v.row(1).array();  // (0,2)
+  out.row(2).array() -= a*v.row(1).array();  // (2,0)
+  out.row(1).array() += a*v.row(2).array();  // (1,0)
+  out.row(3).array() -= a*v.row(2).array();  // (0,1)
+}
+
+} // namespace batch
+
+static void ExpBatch(const BatchMat<3>& v, BatchMat<4>& q){
+  q.resize(4,v.cols());
+  const BatchArray t2 = batch::SquaredNorm(v);
+  const BatchArray f = 0.5*batch::SinOverAngle(0.25*t2);
+  for(int i=0;i<3;i++){
+    q.row(i).array() = f*v.row(i).array();
+  }
+  q.row(3).array() = (0.5*t2.sqrt()).cos();
+}
+static void LogBatch(const BatchMat<4>& q, BatchMat<3>& v){
+  v.resize(3,q.cols());
+  const BatchArray re = q.row(3).array();
+  const BatchArray s2 = q.row(0).array().square() + q.row(1).array().square() + q.row(2).array().square();
+  const auto small = s2 < kSmallAngle2*kSmallAngle2;
+  const BatchArray sha = s2.sqrt();
+  const BatchArray f = small.select(2.0/re*(1.0 - s2/(3.0*re*re)), 2.0*(sha/re).atan()/small.select(1.0,sha));
+  for(int i=0;i<3;i++){
+    v.row(i).array() = f*q.row(i).array();
+  }
+}
+/*! \brief Quaternion product out = p*q for each pair of columns.
+ */
+static void QuatProductBatch(const BatchMat<4>& p, const BatchMat<4>& q, BatchMat<4>& out){
+  out.resize(4,q.cols());
+  const auto px = p.row(0).array(), py = p.row(1).array(), pz = p.row(2).array(), pw = p.row(3).array();
+  const auto qx = q.row(0).array(), qy = q.row(1).array(), qz = q.row(2).array(), qw = q.row(3).array();
+  out.row(0).array() = pw*qx + px*qw + py*qz - pz*qy;
+  out.row(1).array() = pw*qy - px*qz + py*qw + pz*qx;
+  out.row(2).array() = pw*qz + px*qy - py*qx + pz*qw;
+  out.row(3).array() = pw*qw - px*qx - py*qy - pz*qz;
+}
+static void BoxplusBatch(const BatchMat<4>& q, const BatchMat<3>& v, BatchMat<4>& out){
+  BatchMat<4> e;
+  ExpBatch(v,e);
+  QuatProductBatch(e,q,out);
+}
+static void RotMatBatch(const BatchMat<3>& v, BatchMat<9>& R){
+  const BatchArray t2 = batch::SquaredNorm(v);
+  batch::SO3Poly(v, t2, batch::SinOverAngle(t2), batch::OneMinusCosOverAngle2(t2), R);
+}
+static void GammaMatBatch(const BatchMat<3>& v, BatchMat<9>& G){
+  const BatchArray t2 = batch::SquaredNorm(v);
+  batch::SO3Poly(v, t2, batch::OneMinusCosOverAngle2(t2), batch::AngleMinusSinOverAngle3(t2), G);
+}
+static void GammaMatInvBatch(const BatchMat<3>& v, BatchMat<9>& G){
+  const BatchArray t2 = batch::SquaredNorm(v);
+  batch::SO3Poly(v, t2, BatchArray::Constant(v.cols(),-0.5), batch::GammaInvCoeff(t2), G);
 }
 
 } // namespace tsif
@@ -0,0 +1,77 @@
+#ifndef TSIF_SNAPSHOT_BUFFER_HPP_
+#define TSIF_SNAPSHOT_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+
+namespace tsif{
+
+/*! \brief Snapshot Buffer
+ *         Publication of a value by a single writer to concurrent readers (RCU-style multi-buffering). The writer fills a
+ *         slot which is neither published nor being read and then publishes it with a single atomic store. Readers pin
+ *         the published slot with a reader count and copy it, they never block the writer and only retry if a
+ *         publication happens between loading and pinning the slot. If all unpublished slots are pinned, the writer
+ *         skips the publication instead of waiting (readers then keep seeing the previous value).
+ */
+template<typename T, int N = 4>
+class SnapshotBuffer{
+  static_assert(N >= 2, "At least two slots required");
+ public:
+  SnapshotBuffer(){
+    Reset();
+  }
+  // Copies start out empty, the slots belong to the readers of the original
+  SnapshotBuffer(const SnapshotBuffer& /*other*/){
+    Reset();
+  }
+  SnapshotBuffer& operator=(const SnapshotBuffer& /*other*/){
+    Reset();
+    return *this;
+  }
+  /*! \brief Writer side, fill(T&) writes the new value into a free slot. Returns false if the publication was skipped.
+   */
+  template<typename F>
+  bool Publish(F fill){
+    const int latest = latest_.load(std::memory_order_relaxed);
+    for(int i=0;i<N;i++){
+      if(i != latest && readers_[i].load() == 0){
+        fill(slots_[i]);
+        latest_.store(i);
+        return true;
+      }
+    }
+    return false;
+  }
+  /*! \brief Reader side, copies the latest published value. Returns false if nothing has been published yet.
+   */
+  bool Read(T& out) const{
+    while(true){
+      const int i = latest_.load();
+      if(i < 0){
+        return false;
+      }
+      readers_[i].fetch_add(1);
+      if(latest_.load() == i){
+        out = slots_[i];
+        readers_[i].fetch_sub(1);
+        return true;
+      }
+      readers_[i].fetch_sub(1);
+    }
+  }
+
+ private:
+  void Reset(){
+    latest_ = -1;
+    for(auto& count : readers_){
+      count = 0;
+    }
+  }
+  std::array<T,N> slots_;
+  std::atomic<int> latest_;
+  mutable std::array<std::atomic<int>,N> readers_;
+};
+
+} // namespace tsif
+
+#endif /* TSIF_SNAPSHOT_BUFFER_HPP_ */
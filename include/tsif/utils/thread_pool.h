@@ -0,0 +1,219 @@
+#ifndef TSIF_THREAD_POOL_HPP_
+#define TSIF_THREAD_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tsif{
+
+/*! \brief Thread Pool
+ *         Fixed set of worker threads executing index ranges (ParallelFor). Every participant (the calling thread
+ *         included) starts on its own contiguous share of the indices and, once it runs dry, steals the back half of
+ *         the largest remaining share. Which thread executes an index is not deterministic, so the tasks must only
+ *         write to disjoint outputs. Nested and concurrent calls are supported (nested calls run serially).
+ *         Independent tasks can be submitted as well (Submit), the workers run them in order between the loops.
+ */
+class ThreadPool{
+ public:
+  explicit ThreadPool(int numThreads = std::thread::hardware_concurrency())
+      : numThreads_(std::max(numThreads,1)), ranges_(new Range[numThreads_]){
+    stop_ = false;
+    generation_ = 0;
+    busy_ = 0;
+    remaining_ = 0;
+    for(int i=1;i<numThreads_;i++){
+      workers_.emplace_back(&ThreadPool::WorkerLoop,this,i);
+    }
+  }
+  ~ThreadPool(){
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    startCv_.notify_all();
+    for(auto& worker : workers_){
+      worker.join();
+    }
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  int GetNumThreads() const{
+    return numThreads_;
+  }
+  /*! \brief Calls task(i) for all i in [0,n) and returns once all calls have finished.
+   */
+  template<typename F>
+  void ParallelFor(int n, F&& task){
+    if(n <= 0){
+      return;
+    }
+    if(numThreads_ == 1 || n == 1 || CurrentPool() != nullptr){
+      TaskDepth()++;
+      for(int i=0;i<n;i++){
+        task(i);
+      }
+      TaskDepth()--;
+      return;
+    }
+    std::lock_guard<std::mutex> callLock(callMutex_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = std::ref(task);
+      remaining_ = n;
+      for(int i=0;i<numThreads_;i++){
+        std::lock_guard<std::mutex> rangeLock(ranges_[i].mutex_);
+        ranges_[i].begin_ = static_cast<long>(n)*i/numThreads_;
+        ranges_[i].end_ = static_cast<long>(n)*(i+1)/numThreads_;
+      }
+      generation_++;
+    }
+    startCv_.notify_all();
+    Work(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCv_.wait(lock,[this](){ return remaining_ == 0 && busy_ == 0; });
+    job_ = nullptr;
+  }
+  /*! \brief Runs task asynchronously on a worker thread, or right away on the calling thread if the pool has no
+   *         workers. Parallel loops within the task run serially. Pending tasks are finished before destruction.
+   */
+  void Submit(std::function<void()> task){
+    if(numThreads_ == 1){
+      TaskDepth()++;
+      task();
+      TaskDepth()--;
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    startCv_.notify_one();
+  }
+  /*! \brief Is the calling thread running a task of a pool (inline ones included), independently of the number of
+   *         threads. Used to require explicit random streams in tasks (see NormalRandomNumberGenerator).
+   */
+  static bool IsInTask(){
+    return TaskDepth() > 0;
+  }
+
+ private:
+  struct Range{
+    std::mutex mutex_;
+    int begin_ = 0;
+    int end_ = 0;
+  };
+  static ThreadPool*& CurrentPool(){
+    thread_local ThreadPool* pool = nullptr;
+    return pool;
+  }
+  static int& TaskDepth(){
+    thread_local int depth = 0;
+    return depth;
+  }
+  void WorkerLoop(int id){
+    long seen = 0;
+    while(true){
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        startCv_.wait(lock,[this,&seen](){ return stop_ || generation_ != seen || !tasks_.empty(); });
+        if(generation_ != seen){  // Loops first, their caller is blocked
+          seen = generation_;
+          busy_++;
+        } else if(!tasks_.empty()){
+          task = std::move(tasks_.front());
+          tasks_.pop_front();
+        } else {
+          return;  // Stopped and drained
+        }
+      }
+      if(task){
+        CurrentPool() = this;
+        TaskDepth()++;
+        task();
+        TaskDepth()--;
+        CurrentPool() = nullptr;
+        continue;
+      }
+      Work(id);
+      std::lock_guard<std::mutex> lock(mutex_);
+      busy_--;
+      if(busy_ == 0 && remaining_ == 0){
+        doneCv_.notify_all();
+      }
+    }
+  }
+  void Work(int id){
+    CurrentPool() = this;
+    TaskDepth()++;
+    int i;
+    while((i = Pop(id)) >= 0 || (i = Steal(id)) >= 0){
+      job_(i);
+      if(--remaining_ == 0){
+        std::lock_guard<std::mutex> lock(mutex_);
+        doneCv_.notify_all();
+      }
+    }
+    TaskDepth()--;
+    CurrentPool() = nullptr;
+  }
+  int Pop(int id){
+    std::lock_guard<std::mutex> lock(ranges_[id].mutex_);
+    return ranges_[id].begin_ < ranges_[id].end_ ? ranges_[id].begin_++ : -1;
+  }
+  int Steal(int id){
+    while(true){
+      int victim = -1;
+      int size = 0;
+      for(int i=0;i<numThreads_;i++){
+        std::lock_guard<std::mutex> lock(ranges_[i].mutex_);
+        if(ranges_[i].end_ - ranges_[i].begin_ > size){
+          victim = i;
+          size = ranges_[i].end_ - ranges_[i].begin_;
+        }
+      }
+      if(victim < 0){
+        return -1;
+      }
+      int begin, end;
+      {
+        std::lock_guard<std::mutex> lock(ranges_[victim].mutex_);
+        size = ranges_[victim].end_ - ranges_[victim].begin_;
+        if(size <= 0){
+          continue;  // Emptied in the meantime
+        }
+        end = ranges_[victim].end_;
+        begin = end - (size+1)/2;
+        ranges_[victim].end_ = begin;
+      }
+      std::lock_guard<std::mutex> lock(ranges_[id].mutex_);
+      ranges_[id].begin_ = begin+1;
+      ranges_[id].end_ = end;
+      return begin;
+    }
+  }
+  const int numThreads_;
+  std::unique_ptr<Range[]> ranges_;
+  std::vector<std::thread> workers_;
+  std::mutex callMutex_;
+  std::mutex mutex_;
+  std::condition_variable startCv_;
+  std::condition_variable doneCv_;
+  std::function<void(int)> job_;
+  std::deque<std::function<void()>> tasks_;
+  bool stop_;
+  long generation_;
+  int busy_;
+  std::atomic<int> remaining_;
+};
+
+} // namespace tsif
+
+#endif /* TSIF_THREAD_POOL_HPP_ */
@@ -0,0 +1,75 @@
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/bearing_findif.h"
+
+using namespace tsif;
+
+struct Timing{
+  double analytic;
+  double autodiff;
+  double findif;
+  double colored;
+  double error;
+};
+
+// Average time of one JacPre plus one JacCur evaluation with each method
+template<typename Res>
+Timing Compare(Res& res, int n){
+  typename Res::Previous pre;
+  typename Res::Current cur;
+  pre.SetRandom();
+  cur.SetRandom();
+  const std::tuple<typename Res::Previous::CRef,typename Res::Current::CRef> ins(pre,cur);
+  MatX JPre(Res::Output::Dim(),Res::Previous::Dim()), JCur(Res::Output::Dim(),Res::Current::Dim());
+  MatX JPreAD(Res::Output::Dim(),Res::Previous::Dim()), JCurAD(Res::Output::Dim(),Res::Current::Dim());
+  JPre.setZero(); JCur.setZero(); JPreAD.setZero(); JCurAD.setZero();
+  Timing timing;
+  Timer timer;
+  for(int i=0;i<n;i++){
+    res.JacPre(JPre,pre,cur);
+    res.JacCur(JCur,pre,cur);
+  }
+  timing.analytic = timer.GetIncr()/n;
+  for(int i=0;i<n;i++){
+    res.JacPreAutoDiff(JPreAD,pre,cur);
+    res.JacCurAutoDiff(JCurAD,pre,cur);
+  }
+  timing.autodiff = timer.GetIncr()/n;
+  MatX JPreFD(JPre), JCurFD(JCur);
+  for(int i=0;i<n;i++){
+    res.template JacFindifFull<0>(1e-8,JPreFD,ins);
+    res.template JacFindifFull<1>(1e-8,JCurFD,ins);
+  }
+  timing.findif = timer.GetIncr()/n;
+  JacColoring coloringPre, coloringCur;
+  res.template JacSparsity<0>(1e-8,1e-12,coloringPre,ins);
+  res.template JacSparsity<1>(1e-8,1e-12,coloringCur,ins);
+  timer.GetIncr();
+  for(int i=0;i<n;i++){
+    res.template JacFindifColored<0>(1e-8,JPreFD,coloringPre,ins);
+    res.template JacFindifColored<1>(1e-8,JCurFD,coloringCur,ins);
+  }
+  timing.colored = timer.GetIncr()/n;
+  timing.error = std::max((JPre-JPreAD).array().abs().maxCoeff(),(JCur-JCurAD).array().abs().maxCoeff());
+  return timing;
+}
+
+void Report(const std::string& name, const Timing& timing){
+  std::cout << name << ": analytic " << timing.analytic*1e6 << " us, autodiff " << timing.autodiff*1e6
+            << " us (" << timing.autodiff/timing.analytic << "x), findif " << timing.findif*1e6
+            << " us (" << timing.findif/timing.analytic << "x), colored findif " << timing.colored*1e6
+            << " us (" << timing.colored/timing.analytic << "x), max difference " << timing.error << std::endl;
+}
+
+int main(int /*argc*/, char** /*argv*/){
+  const int n = 10000;
+
+  AccelerometerPrediction<0,0,1,2,3> acc;
+  acc.dt_ = 0.01;
+  acc.meas_ = std::make_shared<MeasAcc>(Vec3(0.1,-0.2,9.8));
+  Report("AccelerometerPrediction",Compare(acc,n));
+
+  BearingFindif<0,0,1,2,3,4,5,8> bea;
+  bea.dt_ = 0.01;
+  Report("BearingFindif (8 landmarks)",Compare(bea,n/10));
+  return 0;
+}
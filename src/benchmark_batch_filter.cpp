@@ -0,0 +1,74 @@
+#include "tsif/batch_filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0,POS,VEL,ATT>,
+               AttitudeFindif<0,ATT,ROR>,
+               AccelerometerPrediction<0,VEL,ATT,ROR,ACB>,
+               GyroscopeUpdate<0,ROR,GYB>,
+               RandomWalk<Element<Vec3,ACB>>,
+               RandomWalk<Element<Vec3,GYB>>,
+               PositionUpdate<0,POS,ATT,-1,-2,-3>,
+               AttitudeUpdate<0,ATT,-2,-4>> PoseFilter;
+
+// Adds the same random measurements at t to the lanes of the batch and to the independent filters
+void AddMeasurements(BatchFilter<PoseFilter>& batch, std::vector<PoseFilter>& independent, TimePoint t){
+  for(int l=0;l<batch.GetNumLanes();l++){
+    const auto acc = std::make_shared<MeasAcc>(Vec3(0,0,9.81) + 0.1*Vec3::Random());
+    const auto gyr = std::make_shared<MeasGyr>(Vec3::Random());
+    const auto pos = std::make_shared<MeasPos>(Vec3::Random());
+    const auto att = std::make_shared<MeasAtt>(Exp(Vec3(0.1*Vec3::Random())));
+    for(PoseFilter* filter : {&batch.GetFilter(l),&independent[l]}){
+      filter->AddMeas<2>(t,acc);
+      filter->AddMeas<3>(t,gyr);
+      filter->AddMeas<6>(t,pos);
+      filter->AddMeas<7>(t,att);
+    }
+  }
+}
+
+int main(int /*argc*/, char** /*argv*/){
+  const int steps = 200;
+  std::cout << "lanes\tindependent [ms/step]\tbatch [ms/step]\tspeedup\tmax difference" << std::endl;
+  for(int K : {1,4,16,64,256}){
+    BatchFilter<PoseFilter> batch(K);
+    std::vector<PoseFilter> independent(K);
+    const TimePoint start = Clock::now();
+    std::vector<TimePoint> times;
+    for(int i=0;i<steps;i++){
+      times.push_back(start + fromSec(0.01*i));
+      AddMeasurements(batch,independent,times.back());
+    }
+    for(int l=0;l<K;l++){
+      independent[l].Init(times[0]);
+      batch.GetFilter(l).Init(times[0]);
+    }
+    Timer timer;
+    for(int i=1;i<steps;i++){
+      for(auto& filter : independent){
+        filter.MakeUpdateStep(times[i]);
+      }
+    }
+    const double timeIndependent = timer.GetIncr()/(steps-1);
+    for(int i=1;i<steps;i++){
+      batch.MakeUpdateStep(times[i]);
+    }
+    const double timeBatch = timer.GetIncr()/(steps-1);
+    double maxDifference = 0;
+    for(int l=0;l<K;l++){
+      maxDifference = std::max(maxDifference,(batch.GetFilter(l).GetState().Get<POS>()
+                                              - independent[l].GetState().Get<POS>()).cwiseAbs().maxCoeff());
+    }
+    std::cout << K << "\t" << timeIndependent*1e3 << "\t\t\t" << timeBatch*1e3 << "\t\t"
+              << timeIndependent/timeBatch << "\t" << maxDifference << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Synthetic large filter for measuring compile time and memory (see the benchmark_compile_time target)
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/bearing_findif.h"
+#include "tsif/residuals/distance_findif.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB, VEP, VEA, BEA, DIS, IRIJ, QIJ, BRBV, QBV, EX0, EX1, EX2, EX3, EX4, EX5, EX6, EX7 };
+constexpr int kLandmarks = 8;
+
+typedef Filter<PositionFindif<0,POS,VEL,ATT>,
+               AttitudeFindif<0,ATT,ROR>,
+               AccelerometerPrediction<0,VEL,ATT,ROR,ACB>,
+               GyroscopeUpdate<0,ROR,GYB>,
+               BearingFindif<0,BEA,DIS,VEL,ROR,VEP,VEA,kLandmarks>,
+               DistanceFindif<0,BEA,DIS,VEL,ROR,VEP,VEA,kLandmarks>,
+               PositionUpdate<0,POS,ATT,IRIJ,QIJ,BRBV>,
+               AttitudeUpdate<0,ATT,QIJ,QBV>,
+               RandomWalk<Element<Vec3,ACB>,Element<Vec3,GYB>>,
+               RandomWalk<Element<Vec3,VEP>,Element<Quat,VEA>>,
+               RandomWalk<Element<Vec3,IRIJ>,Element<Quat,QIJ>,Element<Vec3,BRBV>,Element<Quat,QBV>>,
+               RandomWalk<Element<Vec3,EX0>,Element<Vec3,EX1>>,
+               RandomWalk<Element<Quat,EX2>,Element<Quat,EX3>>,
+               RandomWalk<Element<Vec3,EX4>,Element<UnitVector,EX5>>,
+               RandomWalk<Element<Vec3,EX6>,Element<double,EX7>>> LargeFilter;
+
+int main(int /*argc*/, char** /*argv*/){
+  LargeFilter filter;
+  filter.JacTestAll(1e-6,1e-8);
+  std::cout << filter.PrintConnectivity() << std::endl;
+  const TimePoint start = Clock::now();
+  for(int i=0;i<10;i++){
+    const TimePoint t = start + fromSec(0.01*i);
+    filter.AddMeas<2>(t,std::make_shared<MeasAcc>(Vec3(0,0,9.81)));
+    filter.AddMeas<3>(t,std::make_shared<MeasGyr>(Vec3(0,0,0)));
+    filter.AddMeas<6>(t,std::make_shared<MeasPos>(Vec3(0,0,0)));
+    filter.AddMeas<7>(t,std::make_shared<MeasAtt>(Quat(1,0,0,0)));
+    filter.Update();
+  }
+  std::cout << filter.GetState().Print() << std::endl;
+  return 0;
+}
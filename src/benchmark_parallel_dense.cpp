@@ -0,0 +1,67 @@
+#include "tsif/utils/parallel_dense.h"
+#include "tsif/utils/timing.h"
+
+using namespace tsif;
+
+// Random problem with the structure of a filter update (SPD prior and Gram blocks of a random Jacobian)
+struct Problem{
+  MatX I, Hpp, Hpc, Hcc;
+  VecX bp, bc;
+  explicit Problem(int n){
+    const MatX J = MatX::Random(2*n,2*n);
+    const MatX H = J.transpose()*J;
+    I = MatX::Identity(n,n);
+    Hpp = H.topLeftCorner(n,n);
+    Hpc = H.topRightCorner(n,n);
+    Hcc = H.bottomRightCorner(n,n);
+    bp = VecX::Random(n);
+    bc = VecX::Random(n);
+  }
+};
+
+// Same kernels as Filter::ComputeUpdate
+VecX SolveSerial(const Problem& p){
+  Eigen::LDLT<MatX> D_LDLT(p.I+p.Hpp);
+  const MatX DinvHpc = D_LDLT.solve(p.Hpc);
+  MatX newInf = p.Hcc - p.Hpc.transpose()*DinvHpc;
+  newInf = 0.5*(newInf + newInf.transpose().eval());
+  Eigen::LDLT<MatX> I_LDLT(newInf);
+  return -I_LDLT.solve(p.bc - DinvHpc.transpose()*p.bp);
+}
+
+// Same kernels as Filter::ComputeUpdateParallel
+VecX SolveParallel(ThreadPool& pool, const Problem& p){
+  MatX L = p.I+p.Hpp;
+  ParallelLLT(pool,L);
+  MatX Y = p.Hpc;
+  ParallelLowerSolve(pool,L,Y);
+  const VecX z = L.triangularView<Eigen::Lower>().solve(p.bp);
+  MatX newInf = p.Hcc;
+  ParallelSubtractGram(pool,Y,newInf);
+  ParallelLLT(pool,newInf);
+  const VecX grad = p.bc - Y.transpose()*z;
+  return -newInf.transpose().triangularView<Eigen::Upper>().solve(newInf.triangularView<Eigen::Lower>().solve(grad));
+}
+
+int main(int /*argc*/, char** /*argv*/){
+  ThreadPool pool;
+  std::cout << "Threads: " << pool.GetNumThreads() << std::endl;
+  std::cout << "dim\tserial [ms]\tparallel [ms]\tspeedup\tmax difference" << std::endl;
+  for(int n : {25,50,100,150,200,300,400,600,800}){
+    const Problem p(n);
+    const int repetitions = std::max(2,int(2e8/(double(n)*n*n)));
+    VecX dxSerial, dxParallel;
+    Timer timer;
+    for(int i=0;i<repetitions;i++){
+      dxSerial = SolveSerial(p);
+    }
+    const double timeSerial = timer.GetIncr()/repetitions;
+    for(int i=0;i<repetitions;i++){
+      dxParallel = SolveParallel(pool,p);
+    }
+    const double timeParallel = timer.GetIncr()/repetitions;
+    std::cout << n << "\t" << timeSerial*1e3 << "\t\t" << timeParallel*1e3 << "\t\t" << timeSerial/timeParallel << "\t"
+              << (dxSerial-dxParallel).cwiseAbs().maxCoeff() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+// Inertial pose filter, identical up to the scalar type of states and Jacobians
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+template<typename S>
+using PoseFilter = Filter<PositionFindif<0,POS,VEL,ATT,S>,
+                          AttitudeFindif<0,ATT,ROR,S>,
+                          AccelerometerPrediction<0,VEL,ATT,ROR,ACB,S>,
+                          GyroscopeUpdate<0,ROR,GYB,S>,
+                          RandomWalk<Element<Vec<3,S>,ACB>>,
+                          RandomWalk<Element<Vec<3,S>,GYB>>,
+                          PositionUpdate<0,POS,ATT,-1,-2,-3,S>,
+                          AttitudeUpdate<0,ATT,-2,-4,S>>;
+
+struct Sample{
+  Vec3 pos;
+  Quat att;
+  Vec3 acc;
+  Vec3 gyr;
+};
+
+// Constant body rate and body velocity, measurements without noise
+std::vector<Sample> Simulate(int n, double dt){
+  const Vec3 ror(0.1,-0.2,0.3);
+  const Vec3 vel(1.0,0.5,0.0);
+  const Vec3 g(0,0,-9.81);
+  std::vector<Sample> samples(n);
+  Vec3 pos(0,0,0);
+  Quat att(1,0,0,0);
+  for(int i=0;i<n;i++){
+    samples[i].pos = pos;
+    samples[i].att = att;
+    samples[i].acc = ror.cross(vel) - att.inverse().toRotationMatrix()*g;
+    samples[i].gyr = ror;
+    for(int j=0;j<10;j++){
+      pos += 0.1*dt*att.toRotationMatrix()*vel;
+      att = att*Exp(0.1*dt*ror);
+    }
+  }
+  return samples;
+}
+
+template<typename S>
+double Run(const std::vector<Sample>& samples, double dt, std::vector<Vec3>& pos, std::vector<Quat>& att){
+  PoseFilter<S> filter;
+  const TimePoint start = Clock::now();
+  double time = 0;
+  for(unsigned int i=0;i<samples.size();i++){
+    const TimePoint t = start + fromSec(i*dt);
+    filter.template AddMeas<2>(t,std::make_shared<MeasAcc>(samples[i].acc));
+    filter.template AddMeas<3>(t,std::make_shared<MeasGyr>(samples[i].gyr));
+    filter.template AddMeas<6>(t,std::make_shared<MeasPos>(samples[i].pos));
+    filter.template AddMeas<7>(t,std::make_shared<MeasAtt>(samples[i].att));
+    Timer timer;
+    filter.Update();
+    time += timer.GetFull();
+    pos.push_back(filter.GetState().template Get<POS>().template cast<double>());
+    att.push_back(filter.GetState().template Get<ATT>().template cast<double>());
+  }
+  return time/samples.size();
+}
+
+int main(int /*argc*/, char** /*argv*/){
+  const int n = 2000;
+  const double dt = 0.01;
+  const std::vector<Sample> samples = Simulate(n,dt);
+
+  std::vector<Vec3> posD, posF;
+  std::vector<Quat> attD, attF;
+  const double timeD = Run<double>(samples,dt,posD,attD);
+  const double timeF = Run<float>(samples,dt,posF,attF);
+
+  // Errors after the initial velocity transient
+  double posErrD = 0, posErrF = 0, posDif = 0, attErrD = 0, attErrF = 0, attDif = 0;
+  for(unsigned int i=100;i<posD.size();i++){
+    posErrD = std::max(posErrD,(posD[i]-samples[i].pos).norm());
+    posErrF = std::max(posErrF,(posF[i]-samples[i].pos).norm());
+    posDif = std::max(posDif,(posF[i]-posD[i]).norm());
+    attErrD = std::max(attErrD,Boxminus(attD[i],samples[i].att).norm());
+    attErrF = std::max(attErrF,Boxminus(attF[i],samples[i].att).norm());
+    attDif = std::max(attDif,Boxminus(attF[i],attD[i]).norm());
+  }
+
+  std::cout << "Updates: " << posD.size() << ", state dimension: " << PoseFilter<double>::State::Dim() << std::endl;
+  std::cout << "double: " << timeD*1e6 << " us/update, max error pos " << posErrD << " att " << attErrD << std::endl;
+  std::cout << "float:  " << timeF*1e6 << " us/update, max error pos " << posErrF << " att " << attErrF << std::endl;
+  std::cout << "speedup: " << timeD/timeF << ", max float/double difference pos " << posDif << " att " << attDif << std::endl;
+  return 0;
+}
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/pose_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/random_walk.h"
+#include "tsif/utils/option.h"
+#include "tsif/utils/random.h"
+#include "tsif/utils/thread_pool.h"
+
+using namespace tsif;
+
+// Offline Monte Carlo harness: simulates ground truth trajectories from the process model of the filter (with the noise
+// implied by the residual weights), runs one filter instance per trajectory on a thread pool and reports consistency
+// (NEES), accuracy (RMSE) and throughput (updates/sec, latency of Update()). Every run draws from its own Philox stream,
+// such that everything but the timings is reproducible for a seed independently of the number of threads.
+//
+// Usage: monte_carlo [runs] [threads] [seed] [cfg file with the w_* residual weights, e.g. cfg/vio.cfg]
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0,POS,VEL,ATT>,
+               AttitudeFindif<0,ATT,ROR>,
+               AccelerometerPrediction<0,VEL,ATT,ROR,ACB>,
+               GyroscopeUpdate<0,ROR,GYB>,
+               RandomWalk<Element<Vec3,ACB>>,
+               RandomWalk<Element<Vec3,GYB>>,
+               PoseUpdate<0,1,POS,ATT,-1,-2,-3,-4>> PoseFilter;
+typedef PoseFilter::State State;
+
+struct Config{
+  double dt_ = 0.01;       // IMU period [s]
+  int poseDivider_ = 10;   // Pose measurement every poseDivider_ IMU samples
+  double duration_ = 20;   // [s]
+  double settling_ = 1;    // Start of the statistics [s]
+  double w_posfd_ = 1e2;   // Residual weights (defaults of cfg/vio.cfg)
+  double w_attfd_ = 1e3;
+  double w_accpre_ = 1e1;
+  double w_gyrupd_ = 1e3;
+  double w_accbias_ = 1e3;
+  double w_gyrbias_ = 1e3;
+  double w_poseupd_ = 1e2;
+  Vec<18> priorStd_ = (Vec<18>() << Vec3::Constant(0.1), Vec3::Constant(0.1), Vec3::Constant(0.05),
+                       Vec3::Constant(0.1), Vec3::Constant(0.1), Vec3::Constant(0.01)).finished();
+  int GetSteps() const{
+    return std::lround(duration_/dt_);
+  }
+};
+
+// Filter with the prior of the simulation
+class MonteCarloFilter: public PoseFilter{
+ public:
+  MonteCarloFilter(const Config& config){
+    std::get<0>(residuals_).w_ = config.w_posfd_;
+    std::get<1>(residuals_).w_ = config.w_attfd_;
+    std::get<2>(residuals_).w_ = config.w_accpre_;
+    std::get<3>(residuals_).w_ = config.w_gyrupd_;
+    std::get<4>(residuals_).w_ = config.w_accbias_;
+    std::get<5>(residuals_).w_ = config.w_gyrbias_;
+    std::get<6>(residuals_).w_ = config.w_poseupd_;
+    priorInformation_ = config.priorStd_.cwiseAbs2().cwiseInverse().asDiagonal();
+    // Update at every IMU sample: all measurements up to the latest one are available (offline), no waiting for poses
+    SetMaxWaitTimes(0);
+    include_max_ = true;
+  }
+  virtual void Init(TimePoint t){
+    PoseFilter::Init(t);
+    if(is_initialized_){
+      I_ = priorInformation_;  // Prior mean is the identity
+    }
+  }
+ private:
+  MatX priorInformation_;
+};
+
+// Estimation errors and timings of a single run
+struct RunResult{
+  std::vector<double> nees_;     // Per step, full state
+  std::vector<double> neesPos_;  // Per step, position marginal
+  std::vector<double> neesAtt_;  // Per step, attitude marginal
+  Vec<5> squaredErrors_ = Vec<5>::Zero();  // Summed over the steps after settling: pos, vel, att, acb, gyb
+  std::vector<double> latencies_;
+  State final_;
+};
+
+double MarginalNees(const VecX& e, const MatX& P, int start){
+  return e.segment<3>(start).dot(P.block<3,3>(start,start).llt().solve(e.segment<3>(start)));
+}
+
+RunResult Run(const Config& config, uint64_t seed, int run){
+  PhiloxNormalGenerator random(seed,run);
+  NormalRandomNumberGenerator::Instance().SetStream(seed,run);  // Drawn from by the residuals of the filter
+  const double dt = config.dt_;
+  const int steps = config.GetSteps();
+
+  // Random excitation: rotational rate and world acceleration are sinusoids with random amplitudes and frequencies
+  const Vec3 rorAmplitude = 0.5*random.GetVec<3>();
+  const Vec3 rorFrequency = 1.0 + 0.2*random.GetVec<3>().array();
+  const Vec3 accAmplitude = random.GetVec<3>();
+  const Vec3 accFrequency = 0.5 + 0.1*random.GetVec<3>().array();
+  const Vec3 accPhase = random.GetVec<3>();
+  const Vec3 g(0,0,-9.81);
+
+  // Initial truth drawn from the prior (centered at the identity)
+  State truth;
+  State identity;
+  identity.SetIdentity();
+  identity.Boxplus(config.priorStd_.cwiseProduct(random.GetVec<18>()),truth);
+
+  MonteCarloFilter filter(config);
+  RunResult result;
+  const TimePoint start = TimePoint() + fromSec(1);
+  const double sqrtDt = std::sqrt(dt);
+  VecX e(State::Dim());
+  for(int k=0;k<=steps;k++){
+    const TimePoint t = start + fromSec(k*dt);
+    if(k == 0){
+      filter.AddMeas<2>(t,std::make_shared<MeasAcc>(Vec3(-g)));  // Not used, aligns the timelines for the initialization
+    } else {
+      // Propagate the truth from k-1 to k with the (discrete) process model of the residuals
+      const double time = (k-1)*dt;
+      const Mat3 C = truth.Get<ATT>().toRotationMatrix();
+      const Vec3 ror = truth.Get<ROR>();
+      const Vec3 accWorld = accAmplitude.cwiseProduct((accFrequency*time+accPhase).array().sin().matrix());
+      const Vec3 specificForce = C.transpose()*(accWorld-g);
+      filter.AddMeas<2>(t,std::make_shared<MeasAcc>(Vec3(specificForce+truth.Get<ACB>()
+                                                         +random.GetVec<3>()/(config.w_accpre_*sqrtDt))));
+      truth.Get<POS>() += dt*C*truth.Get<VEL>() + sqrtDt/config.w_posfd_*random.GetVec<3>();
+      truth.Get<VEL>() = (Mat3::Identity()-SSM(dt*ror))*truth.Get<VEL>() + dt*C.transpose()*accWorld;
+      truth.Get<ATT>() = Boxplus(Quat(truth.Get<ATT>()*Exp(dt*ror)),Vec3(sqrtDt/config.w_attfd_*random.GetVec<3>()));
+      truth.Get<ROR>() = rorAmplitude.cwiseProduct((rorFrequency*(k*dt)).array().sin().matrix());
+      truth.Get<ACB>() += sqrtDt/config.w_accbias_*random.GetVec<3>();
+      truth.Get<GYB>() += sqrtDt/config.w_gyrbias_*random.GetVec<3>();
+    }
+    filter.AddMeas<3>(t,std::make_shared<MeasGyr>(Vec3(truth.Get<ROR>()+truth.Get<GYB>()
+                                                       +random.GetVec<3>()/(config.w_gyrupd_*sqrtDt))));
+    if(k % config.poseDivider_ == 0){
+      const Vec<6> n = random.GetVec<6>()/config.w_poseupd_;
+      filter.AddMeas<6>(t,std::make_shared<MeasPose>(Vec3(truth.Get<POS>()+n.head<3>()),
+                                                     Boxplus(truth.Get<ATT>(),n.tail<3>())));
+    }
+    Timer timer;
+    filter.Update();
+    result.latencies_.push_back(timer.GetFull());
+
+    // Errors in the tangent space of the estimate
+    truth.Boxminus(filter.GetState(),e);
+    const MatX P = filter.GetCovariance();
+    result.nees_.push_back(e.dot(filter.GetInformation()*e));
+    result.neesPos_.push_back(MarginalNees(e,P,State::Start(POS)));
+    result.neesAtt_.push_back(MarginalNees(e,P,State::Start(ATT)));
+    if(k*dt >= config.settling_){
+      result.squaredErrors_ += (Vec<5>() << e.segment<3>(State::Start(POS)).squaredNorm(),
+                                e.segment<3>(State::Start(VEL)).squaredNorm(),
+                                e.segment<3>(State::Start(ATT)).squaredNorm(),
+                                e.segment<3>(State::Start(ACB)).squaredNorm(),
+                                e.segment<3>(State::Start(GYB)).squaredNorm()).finished();
+    }
+  }
+  result.final_ = filter.GetState();
+  return result;
+}
+
+// Two-sided 95% interval of the average of runs NEES samples with dim degrees of freedom (Wilson-Hilferty)
+std::pair<double,double> NeesBounds(int dim, int runs){
+  const double k = dim*runs;
+  const double s = std::sqrt(2.0/(9.0*k));
+  return {k*std::pow(1.0-2.0/(9.0*k)-1.96*s,3)/runs, k*std::pow(1.0-2.0/(9.0*k)+1.96*s,3)/runs};
+}
+
+// Reports the run-averaged NEES over the steps after settling
+void ReportNees(const std::string& name, const std::vector<RunResult>& results, std::vector<double> RunResult::* nees,
+                int dim, int first){
+  const int runs = results.size();
+  const std::pair<double,double> bounds = NeesBounds(dim,runs);
+  double sum = 0;
+  int inside = 0;
+  const int steps = (results[0].*nees).size();
+  for(int k=first;k<steps;k++){
+    double average = 0;
+    for(const RunResult& result : results){
+      average += (result.*nees)[k]/runs;
+    }
+    sum += average;
+    inside += average >= bounds.first && average <= bounds.second;
+  }
+  std::cout << "NEES " << name << " (dim " << dim << "):\tmean " << sum/(steps-first) << "\t95% bounds ["
+            << bounds.first << ", " << bounds.second << "]\tsteps inside " << 100.0*inside/(steps-first) << "%"
+            << std::endl;
+}
+
+double Percentile(std::vector<double>& samples, double p){
+  const size_t n = std::min<size_t>(samples.size()-1,p*samples.size());
+  std::nth_element(samples.begin(),samples.begin()+n,samples.end());
+  return samples[n];
+}
+
+void LoadWeight(const std::string& file, const std::string& name, double& w){
+  try{
+    OptionLoader::Instance().Get(file,name,w);
+  } catch(const std::out_of_range&){}  // Keep the default
+}
+
+int main(int argc, char** argv){
+  const int runs = argc > 1 ? std::stoi(argv[1]) : 64;
+  const int threads = argc > 2 ? std::stoi(argv[2]) : std::max(1u,std::thread::hardware_concurrency());
+  const uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 0;
+  Config config;
+  if(argc > 4){
+    LoadWeight(argv[4],"w_posfd",config.w_posfd_);
+    LoadWeight(argv[4],"w_attfd",config.w_attfd_);
+    LoadWeight(argv[4],"w_accpre",config.w_accpre_);
+    LoadWeight(argv[4],"w_gyrupd",config.w_gyrupd_);
+    LoadWeight(argv[4],"w_accbias",config.w_accbias_);
+    LoadWeight(argv[4],"w_gyrbias",config.w_gyrbias_);
+    LoadWeight(argv[4],"w_poseupd",config.w_poseupd_);
+  }
+  std::cout << runs << " runs of " << config.GetSteps() << " steps, " << threads << " threads, seed " << seed
+            << std::endl;
+
+  ThreadPool pool(threads);
+  std::vector<RunResult> results(runs);
+  Timer timer;
+  pool.ParallelFor(runs,[&](int i){ results[i] = Run(config,seed,i); });
+  const double wallTime = timer.GetFull();
+
+  const int first = std::lround(config.settling_/config.dt_);
+  ReportNees("state",results,&RunResult::nees_,State::Dim(),first);
+  ReportNees("pos",results,&RunResult::neesPos_,3,first);
+  ReportNees("att",results,&RunResult::neesAtt_,3,first);
+  Vec<5> squaredErrors = Vec<5>::Zero();
+  double checksum = 0;
+  std::vector<double> latencies;
+  State identity;
+  identity.SetIdentity();
+  VecX e(State::Dim());
+  for(const RunResult& result : results){
+    squaredErrors += result.squaredErrors_;
+    latencies.insert(latencies.end(),result.latencies_.begin(),result.latencies_.end());
+    result.final_.Boxminus(identity,e);
+    checksum += e.sum();
+  }
+  const Vec<5> rmse = (squaredErrors/(runs*(config.GetSteps()+1-first))).cwiseSqrt();
+  std::cout << "RMSE pos " << rmse(0) << " m, vel " << rmse(1) << " m/s, att " << rmse(2)*180/M_PI << " deg, acb "
+            << rmse(3) << " m/s^2, gyb " << rmse(4) << " rad/s" << std::endl;
+  std::cout.precision(17);
+  std::cout << "Checksum of the final estimates: " << checksum << std::endl;
+  std::cout.precision(6);
+  std::cout << "Throughput: " << latencies.size()/wallTime << " updates/s (" << wallTime << " s wall time)" << std::endl;
+  std::cout << "Update latency [us]: p50 " << Percentile(latencies,0.5)*1e6 << ", p90 " << Percentile(latencies,0.9)*1e6
+            << ", p99 " << Percentile(latencies,0.99)*1e6 << ", max " << Percentile(latencies,1.0)*1e6 << std::endl;
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/bearing_findif.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef ElementVector<Element<Vec3, 0>> DragOutput;
+typedef ElementVector<Element<Vec3, 0>, Element<Quat, 1>> DragState;
+
+// Residual which only implements EvalRes, its Jacobians come from automatic differentiation
+template <typename S = double>
+class QuadraticDrag : public ResidualBase<QuadraticDrag<S>, ElementVector<Element<Vec<3, S>, 0>>,
+                                          ElementVector<Element<Vec<3, S>, 0>, Element<QuatT<S>, 1>>,
+                                          ElementVector<Element<Vec<3, S>, 0>>, MeasEmpty> {
+ public:
+  typedef ResidualBase<QuadraticDrag<S>, ElementVector<Element<Vec<3, S>, 0>>,
+                       ElementVector<Element<Vec<3, S>, 0>, Element<QuatT<S>, 1>>, ElementVector<Element<Vec<3, S>, 0>>,
+                       MeasEmpty>
+      Base;
+  template <typename T>
+  using Rebind = QuadraticDrag<T>;
+  S drag_;  // Drag coefficient
+  QuadraticDrag() : Base(true, true, true), drag_(0.1) {}
+  template <typename Other>
+  void CopyParameters(const Other& other) {
+    Base::CopyParameters(other);
+    drag_ = S(other.drag_);
+  }
+  int EvalRes(typename Base::Output::Ref out, const typename Base::Previous::CRef pre, const typename Base::Current::CRef cur) {
+    const Vec<3, S>& vel = pre.template Get<0>();
+    const Vec<3, S> g = pre.template Get<1>().inverse().toRotationMatrix() * Vec<3, S>(S(0), S(0), S(-9.81));
+    out.template Get<0>() = cur.template Get<0>() - vel - S(this->dt_) * (g - drag_ * vel.norm() * vel);
+    return 0;
+  }
+};
+
+}  // namespace
+
+TEST(AutoDiff, MatchesAnalyticAccelerometerPrediction) {  // NOLINT
+  typedef AccelerometerPrediction<0, 0, 1, 2, 3> Res;
+  Res res;
+  res.dt_ = 0.1;
+  res.meas_ = std::make_shared<MeasAcc>(Vec3(0.3, -0.2, 9.5));
+  Res::Previous pre;
+  Res::Current cur;
+  pre.SetRandom();
+  cur.SetRandom();
+  MatX J(Res::Output::Dim(), Res::Previous::Dim()), J_AD(Res::Output::Dim(), Res::Previous::Dim());
+  J.setZero();
+  J_AD.setZero();
+  res.JacPre(J, pre, cur);
+  EXPECT_EQ(res.JacPreAutoDiff(J_AD, pre, cur), 0);
+  EXPECT_LT((J - J_AD).norm(), 1e-10);
+  MatX K(Res::Output::Dim(), Res::Current::Dim()), K_AD(Res::Output::Dim(), Res::Current::Dim());
+  K.setZero();
+  K_AD.setZero();
+  res.JacCur(K, pre, cur);
+  EXPECT_EQ(res.JacCurAutoDiff(K_AD, pre, cur), 0);
+  EXPECT_LT((K - K_AD).norm(), 1e-10);
+}
+
+TEST(AutoDiff, MatchesAnalyticBearingFindif) {  // NOLINT
+  typedef BearingFindif<0, 0, 1, 2, 3, 4, 5, 3> Res;
+  Res res;
+  res.dt_ = 0.1;
+  Res::Previous pre;
+  Res::Current cur;
+  pre.SetRandom();
+  cur.SetRandom();
+  MatX J(Res::Output::Dim(), Res::Previous::Dim()), J_AD(Res::Output::Dim(), Res::Previous::Dim());
+  J.setZero();
+  J_AD.setZero();
+  res.JacPre(J, pre, cur);
+  res.JacPreAutoDiff(J_AD, pre, cur);
+  EXPECT_LT((J - J_AD).norm(), 1e-8);
+  MatX K(Res::Output::Dim(), Res::Current::Dim()), K_AD(Res::Output::Dim(), Res::Current::Dim());
+  K.setZero();
+  K_AD.setZero();
+  res.JacCur(K, pre, cur);
+  res.JacCurAutoDiff(K_AD, pre, cur);
+  EXPECT_LT((K - K_AD).norm(), 1e-8);
+}
+
+TEST(AutoDiff, EvalResOnlyResidualPassesJacobianTest) {  // NOLINT
+  QuadraticDrag<> res;
+  res.dt_ = 0.1;
+  EXPECT_EQ(res.JacPreTest(1e-6, 1e-8), 0);
+  EXPECT_EQ(res.JacCurTest(1e-6, 1e-8), 0);
+}
+
+TEST(AutoDiff, RebindKeepsResidualParameters) {  // NOLINT
+  QuadraticDrag<> res;
+  res.dt_ = 0.2;
+  res.drag_ = 2.5;
+  EXPECT_EQ(res.JacPreTest(1e-6, 1e-8), 0);
+  EXPECT_EQ(res.JacCurTest(1e-6, 1e-8), 0);
+  // A residual with other parameters on the same thread does not leak into the next one
+  QuadraticDrag<> other;
+  other.dt_ = 0.1;
+  EXPECT_EQ(other.JacPreTest(1e-6, 1e-8), 0);
+}
+
+TEST(AutoDiff, KeptRebindFollowsParametersAndDrawsNoRandomNumbers) {  // NOLINT
+  typedef AccelerometerPrediction<0, 0, 1, 2, 3> Res;
+  Res res;
+  Res::Previous pre;
+  Res::Current cur;
+  pre.SetRandom();
+  cur.SetRandom();
+  MatX J(Res::Output::Dim(), Res::Previous::Dim()), J_AD(Res::Output::Dim(), Res::Previous::Dim());
+  NormalRandomNumberGenerator::Instance().SetSeed(7);
+  const double expected = NormalRandomNumberGenerator::Instance().Get();
+  NormalRandomNumberGenerator::Instance().SetSeed(7);
+  for (double dt : {0.1, 0.3}) {
+    res.dt_ = dt;
+    res.meas_ = std::make_shared<MeasAcc>(Vec3(dt, -0.2, 9.5));
+    J.setZero();
+    J_AD.setZero();
+    res.JacPre(J, pre, cur);
+    res.JacPreAutoDiff(J_AD, pre, cur);
+    EXPECT_LT((J - J_AD).norm(), 1e-10);
+  }
+  EXPECT_EQ(NormalRandomNumberGenerator::Instance().Get(), expected);
+}
+
+TEST(AutoDiff, DetectsRebind) {  // NOLINT
+  EXPECT_TRUE(HasRebindTrait<QuadraticDrag<>>::value);
+  EXPECT_TRUE((HasRebindTrait<RandomWalk<Element<Vec3, 0>>>::value));
+  EXPECT_FALSE((HasRebindTrait<Residual<DragOutput, DragState, DragOutput, MeasEmpty>>::value));
+}
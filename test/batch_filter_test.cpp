@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include "tsif/batch_filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>,
+               PositionUpdate<0, POS, ATT, -1, -2, -3>, AttitudeUpdate<0, ATT, -2, -4>>
+    PoseFilter;
+
+// Feeds different random measurements to every lane (and the same ones to the corresponding independent filter)
+void AddPoseMeasurements(PoseFilter& a, PoseFilter& b, TimePoint t) {
+  const auto acc = std::make_shared<MeasAcc>(Vec3(0, 0, 9.81) + 0.1 * Vec3::Random());
+  const auto gyr = std::make_shared<MeasGyr>(Vec3::Random());
+  const auto pos = std::make_shared<MeasPos>(Vec3::Random());
+  const auto att = std::make_shared<MeasAtt>(Exp(Vec3(0.1 * Vec3::Random())));
+  for (PoseFilter* filter : {&a, &b}) {
+    filter->AddMeas<2>(t, acc);
+    filter->AddMeas<3>(t, gyr);
+    filter->AddMeas<6>(t, pos);
+    filter->AddMeas<7>(t, att);
+  }
+}
+
+}  // namespace
+
+TEST(BatchFilter, KernelsMatchEigen) {  // NOLINT
+  const int n = 9;
+  const int K = 5;
+  std::vector<MatX> A(K), B(K);
+  BatchMatrix<> batchA(n, n, K), batchB(n, 3, K);
+  for (int l = 0; l < K; l++) {
+    const MatX J = MatX::Random(2 * n, n);
+    A[l] = J.transpose() * J;
+    B[l] = MatX::Random(n, 3);
+    batchA.SetLane(l, A[l]);
+    batchB.SetLane(l, B[l]);
+  }
+  std::vector<char> ok;
+  BatchLLT(batchA, ok);
+  BatchLowerSolve(batchA, batchB);
+  BatchLowerTransposeSolve(batchA, batchB);
+  for (int l = 0; l < K; l++) {
+    EXPECT_TRUE(ok[l]);
+    MatX L(n, n), X(n, 3);
+    batchA.GetLane(l, L);
+    batchB.GetLane(l, X);
+    const MatX expectedL = A[l].llt().matrixL();
+    EXPECT_TRUE(L.triangularView<Eigen::Lower>().toDenseMatrix().isApprox(expectedL, 1e-12));
+    EXPECT_TRUE(X.isApprox(A[l].llt().solve(B[l]), 1e-10));
+  }
+
+  // Lanes which are not positive definite are reported
+  BatchMatrix<> indefinite(2, 2, 2);
+  indefinite.SetLane(0, Mat<2>::Identity());
+  indefinite.SetLane(1, Mat<2>(Vec<2>(1, -1).asDiagonal()));
+  BatchLLT(indefinite, ok);
+  EXPECT_TRUE(ok[0]);
+  EXPECT_FALSE(ok[1]);
+}
+
+TEST(BatchFilter, LockstepMatchesIndependentFilters) {  // NOLINT
+  const int K = 6;
+  BatchFilter<PoseFilter> batch(K);
+  std::vector<PoseFilter> independent(K);
+  std::srand(0);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 100; i++) {
+    const TimePoint t = start + fromSec(0.01 * i);
+    for (int l = 0; l < K; l++) {
+      AddPoseMeasurements(batch.GetFilter(l), independent[l], t);
+      independent[l].Update();
+    }
+    batch.Update();
+  }
+  for (int l = 0; l < K; l++) {
+    const PoseFilter& a = batch.GetFilter(l);
+    const PoseFilter& b = independent[l];
+    EXPECT_EQ(a.GetTime(), b.GetTime());
+    EXPECT_NEAR((a.GetState().Get<POS>() - b.GetState().Get<POS>()).norm(), 0, 1e-9);
+    EXPECT_NEAR((a.GetState().Get<VEL>() - b.GetState().Get<VEL>()).norm(), 0, 1e-9);
+    EXPECT_NEAR(Boxminus(a.GetState().Get<ATT>(), b.GetState().Get<ATT>()).norm(), 0, 1e-9);
+    EXPECT_NEAR((a.GetState().Get<ACB>() - b.GetState().Get<ACB>()).norm(), 0, 1e-9);
+    EXPECT_TRUE(a.GetInformation().isApprox(b.GetInformation(), 1e-9));
+  }
+  // Lanes see different data
+  EXPECT_GT((batch.GetFilter(0).GetState().Get<POS>() - batch.GetFilter(1).GetState().Get<POS>()).norm(), 1e-3);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/bearing_findif.h"
+#include "tsif/residuals/distance_findif.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+TEST(BoundedArray, Activation) {  // NOLINT
+  BoundedArray<UnitVector, 4> x;
+  EXPECT_EQ(x.GetActiveCount(), 0);
+  EXPECT_EQ(x.Activate(), 0);
+  EXPECT_EQ(x.Activate(), 1);
+  x.SetActive(0, false);
+  EXPECT_EQ(x.GetActiveCount(), 1);
+  EXPECT_EQ(x.Activate(), 0);
+  x.SetActive(2, true);
+  x.SetActive(3, true);
+  EXPECT_EQ(x.Activate(), -1);
+  EXPECT_EQ(x.GetActiveCount(), 4);
+}
+
+TEST(BoundedArray, InactiveSlotsArePassedThrough) {  // NOLINT
+  typedef ElementTraits<BoundedArray<UnitVector, 3>> Traits;
+  BoundedArray<UnitVector, 3> x, y;
+  Traits::SetRandom(x);
+  x.SetActive(1, true);
+  const Vec<6> dif = NormalRandomNumberGenerator::Instance().GetVec<6>();
+  Traits::Boxplus(x, dif, y);
+  EXPECT_FALSE(y.IsActive(0));
+  EXPECT_TRUE(y.IsActive(1));
+  EXPECT_LT((y[0].GetVec() - x[0].GetVec()).norm(), 1e-12);
+  EXPECT_LT((y[2].GetVec() - x[2].GetVec()).norm(), 1e-12);
+  Vec<6> out;
+  Traits::Boxminus(y, x, out);
+  EXPECT_LT((out.segment<2>(2) - dif.segment<2>(2)).norm(), 1e-10);
+  EXPECT_EQ(out.segment<2>(0).norm(), 0);
+  EXPECT_EQ(out.segment<2>(4).norm(), 0);
+
+  ElementVector<Element<Vec3, 0>, Element<BoundedArray<UnitVector, 3>, 1>> state;
+  state.SetIdentity();
+  state.Get<1>().SetActive(2, true);
+  std::vector<int> indices;
+  state.GetActiveIndices(indices);
+  EXPECT_EQ(indices, std::vector<int>({0, 1, 2, 7, 8}));
+}
+
+TEST(BoundedArray, LandmarkJacobians) {  // NOLINT
+  typedef BearingFindif<0, 0, 1, 2, 3, 4, 5, 4, double, BoundedArray> Bearing;
+  typedef DistanceFindif<0, 0, 1, 2, 3, 4, 5, 4, double, BoundedArray> Distance;
+  Bearing bearing;
+  Distance distance;
+  Bearing::Previous pre;
+  pre.SetRandom();
+  for (int i : {0, 2, 3}) {
+    pre.Get<0>().SetActive(i, true);
+    pre.Get<1>().SetActive(i, true);
+  }
+  Bearing::Current bearingCur;
+  bearingCur.SetRandom();
+  bearingCur.Get<0>() = pre.Get<0>();
+  EXPECT_EQ(bearing.JacPreTest(1e-6, 1e-8, pre, bearingCur), 0);
+  EXPECT_EQ(bearing.JacCurTest(1e-6, 1e-8, pre, bearingCur), 0);
+  Distance::Current distanceCur;
+  distanceCur.Get<1>() = pre.Get<1>();
+  EXPECT_EQ(distance.JacPreTest(1e-6, 1e-8, pre, distanceCur), 0);
+  EXPECT_EQ(distance.JacCurTest(1e-6, 1e-8, pre, distanceCur), 0);
+}
+
+TEST(BoundedArray, FilterFollowsActiveSlots) {  // NOLINT
+  // Filter on a capacity of 4 with 2 active slots matches a filter on exactly 2 slots
+  typedef Filter<RandomWalk<Element<Vec3, 0>, Element<BoundedArray<Vec3, 4>, 1>>> BoundedFilter;
+  typedef Filter<RandomWalk<Element<Vec3, 0>, Element<std::array<Vec3, 2>, 1>>> FixedFilter;
+  BoundedFilter bounded;
+  FixedFilter fixed;
+  const TimePoint start = Clock::now();
+  bounded.Init(start);
+  fixed.Init(start);
+  bounded.GetState().Get<1>().SetActive(1, true);
+  bounded.GetState().Get<1>().SetActive(3, true);
+  for (int i = 1; i <= 5; i++) {
+    bounded.MakeUpdateStep(start + fromSec(0.1 * i));
+    fixed.MakeUpdateStep(start + fromSec(0.1 * i));
+  }
+  const std::vector<int> active({0, 1, 2, 6, 7, 8, 12, 13, 14});
+  const std::vector<int> inactive({3, 4, 5, 9, 10, 11});
+  const MatX I = bounded.GetInformation();
+  EXPECT_LT((MatX(I(active, active)) - fixed.GetInformation()).norm(), 1e-10);
+  EXPECT_LT((MatX(I(inactive, inactive)) - MatX::Identity(6, 6)).norm(), 1e-12);
+  EXPECT_EQ(MatX(I(active, inactive)).norm(), 0);
+}
+
+TEST(BoundedArray, ReducedProblemIsAssembledOnActiveSlots) {  // NOLINT
+  typedef Filter<RandomWalk<Element<Vec3, 0>, Element<BoundedArray<Vec3, 4>, 1>>> BoundedFilterBase;
+  // Exposes the full and the active problem
+  class BoundedFilter : public BoundedFilterBase {
+   public:
+    using BoundedFilterBase::activeHcc_;
+    using BoundedFilterBase::Hcc_;
+  };
+  BoundedFilter bounded;
+  const TimePoint start = Clock::now();
+  bounded.Init(start);
+  bounded.GetState().Get<1>().SetActive(2, true);
+  bounded.MakeUpdateStep(start + fromSec(0.1));
+  EXPECT_EQ(bounded.Hcc_.size(), 0);  // The full problem is never formed
+  EXPECT_EQ(bounded.activeHcc_.rows(), 6);
+  EXPECT_TRUE(bounded.activeHcc_.isApprox(bounded.activeHcc_(0, 0) * MatX::Identity(6, 6)));
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "tsif/filter.h"
+#include "tsif/filter_scheduler.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>,
+               PositionUpdate<0, POS, ATT, -1, -2, -3>, AttitudeUpdate<0, ATT, -2, -4>>
+    PoseFilter;
+
+struct PoseSample {
+  std::shared_ptr<MeasAcc> acc = std::make_shared<MeasAcc>(Vec3(0, 0, 9.81) + 0.1 * Vec3::Random());
+  std::shared_ptr<MeasGyr> gyr = std::make_shared<MeasGyr>(Vec3::Random());
+  std::shared_ptr<MeasPos> pos = std::make_shared<MeasPos>(Vec3::Random());
+  std::shared_ptr<MeasAtt> att = std::make_shared<MeasAtt>(Exp(Vec3(0.1 * Vec3::Random())));
+};
+
+void AddSample(FilterScheduler::Handle<PoseFilter>& handle, TimePoint t, const PoseSample& s) {
+  handle.AddMeas<2, MeasAcc>(t, s.acc);
+  handle.AddMeas<3, MeasGyr>(t, s.gyr);
+  handle.AddMeas<6, MeasPos>(t, s.pos);
+  handle.AddMeas<7, MeasAtt>(t, s.att);
+}
+
+void AddSample(PoseFilter& filter, TimePoint t, const PoseSample& s) {
+  filter.AddMeas<2>(t, s.acc);
+  filter.AddMeas<3>(t, s.gyr);
+  filter.AddMeas<6>(t, s.pos);
+  filter.AddMeas<7>(t, s.att);
+}
+
+void ExpectSameState(const PoseFilter& a, const PoseFilter& b) {
+  EXPECT_EQ(a.GetTime(), b.GetTime());
+  EXPECT_NEAR((a.GetState().Get<POS>() - b.GetState().Get<POS>()).norm(), 0, 1e-9);
+  EXPECT_NEAR(Boxminus(a.GetState().Get<ATT>(), b.GetState().Get<ATT>()).norm(), 0, 1e-9);
+  EXPECT_TRUE(a.GetInformation().isApprox(b.GetInformation(), 1e-9));
+}
+
+// Stand-in filter whose Update() takes a fixed wall time, for checking that instances are scheduled independently
+class TimedFilter {
+ public:
+  explicit TimedFilter(double duration) : duration_(duration) {}
+  template <int N, typename Measurement>
+  void AddMeas(TimePoint, std::shared_ptr<const Measurement>) {
+    pending_++;
+  }
+  bool HasPendingUpdate() const { return pending_ > 0; }
+  void Update() {
+    pending_ = 0;
+    std::this_thread::sleep_for(std::chrono::duration<double>(duration_));
+    updates_++;
+  }
+  double duration_;
+  int pending_ = 0;
+  std::atomic<int> updates_{0};
+};
+
+}  // namespace
+
+TEST(FilterScheduler, RunOnceMatchesIndependentUpdates) {  // NOLINT
+  const int n = 6;
+  FilterScheduler scheduler(std::make_shared<ThreadPool>(3));
+  std::vector<PoseFilter> scheduled(n), independent(n);
+  std::vector<FilterScheduler::Handle<PoseFilter>> handles;
+  for (auto& filter : scheduled) {
+    handles.push_back(scheduler.Register(&filter));
+  }
+  std::srand(0);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 50; i++) {
+    const TimePoint t = start + fromSec(0.01 * i);
+    for (int l = 0; l < n; l++) {
+      const PoseSample sample;
+      AddSample(handles[l], t, sample);
+      AddSample(independent[l], t, sample);
+      independent[l].Update();
+    }
+    EXPECT_EQ(scheduler.RunOnce(), n);
+    EXPECT_EQ(scheduler.RunOnce(), 0);  // Nothing left to do until new measurements arrive
+  }
+  for (int l = 0; l < n; l++) {
+    ExpectSameState(scheduled[l], independent[l]);
+    const FilterScheduler::InstanceStats stats = scheduler.GetStats(l);
+    EXPECT_EQ(stats.updates_, 50);
+    EXPECT_GE(stats.totalLatency_, stats.totalUpdateTime_);
+  }
+  EXPECT_GT(scheduler.GetFairnessIndex(), 0.0);
+  EXPECT_LE(scheduler.GetFairnessIndex(), 1.0 + 1e-12);
+}
+
+TEST(FilterScheduler, TasksServeConcurrentProducers) {  // NOLINT
+  const int n = 8;
+  const int steps = 60;
+  FilterScheduler scheduler(std::make_shared<ThreadPool>(2));
+  std::vector<PoseFilter> scheduled(n), reference(n);
+  std::vector<FilterScheduler::Handle<PoseFilter>> handles;
+  for (auto& filter : scheduled) {
+    handles.push_back(scheduler.Register(&filter));
+  }
+  std::srand(0);
+  std::vector<std::vector<PoseSample>> samples;
+  for (int l = 0; l < n; l++) {
+    samples.emplace_back(steps);
+  }
+  const TimePoint start = Clock::now();
+  scheduler.Start();
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 4; p++) {
+    producers.emplace_back([&, p]() {
+      for (int i = 0; i < steps; i++) {
+        for (int l = p; l < n; l += 4) {
+          AddSample(handles[l], start + fromSec(0.01 * i), samples[l][i]);
+        }
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  scheduler.Stop();
+  while (scheduler.RunOnce() > 0) {
+  }
+  for (int l = 0; l < n; l++) {
+    for (int i = 0; i < steps; i++) {
+      AddSample(reference[l], start + fromSec(0.01 * i), samples[l][i]);
+    }
+    reference[l].Update();
+    ExpectSameState(scheduled[l], reference[l]);
+    EXPECT_GT(scheduler.GetStats(l).updates_, 0);
+  }
+}
+
+TEST(FilterScheduler, SlowInstanceDoesNotDelayOthers) {  // NOLINT
+  FilterScheduler scheduler(std::make_shared<ThreadPool>(3));
+  TimedFilter slow(0.5), fast(0.001);
+  FilterScheduler::Handle<TimedFilter> slowHandle = scheduler.Register(&slow);
+  FilterScheduler::Handle<TimedFilter> fastHandle = scheduler.Register(&fast);
+  const std::shared_ptr<const double> meas = std::make_shared<double>(0);
+  scheduler.Start();
+  slowHandle.AddMeas<0>(Clock::now(), meas);
+  for (int i = 1; i <= 5; i++) {
+    fastHandle.AddMeas<0>(Clock::now(), meas);
+    const TimePoint start = Clock::now();
+    while (fast.updates_ < i && toSec(Clock::now() - start) < 1.0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(fast.updates_, i);
+  }
+  EXPECT_EQ(slow.updates_, 0);  // The fast instance was served while the slow one was still updating
+  scheduler.Stop();
+  EXPECT_EQ(slow.updates_, 1);
+  EXPECT_EQ(scheduler.GetStats(1).updates_, 5);
+  EXPECT_LT(scheduler.GetStats(1).maxLatency_, 0.25);
+}
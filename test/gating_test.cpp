@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef Filter<GyroscopeUpdate<0, 0, 1>, RandomWalk<Element<Vec3, 0>>, RandomWalk<Element<Vec3, 1>>> GyroFilter;
+
+// Exposes the information matrix for setting up an uncertain prior
+class UncertainGyroFilter : public GyroFilter {
+ public:
+  using GyroFilter::I_;
+};
+
+// Feeds constant gyroscope measurements with a single outlier at step 5
+Vec3 RunGyroFilter(GyroFilter& filter, int steps) {
+  const TimePoint start = Clock::now();
+  for (int i = 1; i <= steps; i++) {
+    const Vec3 gyr = i == 5 ? Vec3(100, -100, 100) : Vec3(0.1, 0.2, 0.3);
+    const TimePoint t = start + fromSec(0.1 * i);
+    filter.AddMeas<0>(t, std::make_shared<MeasGyr>(gyr));
+    if (i == 1) {
+      filter.Init(start);
+    }
+    filter.MakeUpdateStep(t);
+  }
+  return filter.GetState().Get<0>() + filter.GetState().Get<1>();
+}
+
+}  // namespace
+
+TEST(Gating, RejectsOutlierBlock) {  // NOLINT
+  GyroFilter gated, plain, reference;
+  std::get<0>(gated.residuals_).gateTh_ = 16.27;  // 99.9% quantile for 3 degrees of freedom
+  const Vec3 gatedEstimate = RunGyroFilter(gated, 5);
+  const Vec3 plainEstimate = RunGyroFilter(plain, 5);
+  const Vec3 referenceEstimate = RunGyroFilter(reference, 4);
+  EXPECT_EQ(gated.GetRejectionCounts()[0], 1);
+  EXPECT_EQ(gated.GetRejectionCounts()[1], 0);
+  EXPECT_EQ(plain.GetRejectionCounts()[0], 0);
+  EXPECT_LT((gatedEstimate - referenceEstimate).norm(), 1e-10);
+  EXPECT_GT((plainEstimate - referenceEstimate).norm(), 1.0);
+}
+
+TEST(Gating, RobustLossBoundsOutlierInfluence) {  // NOLINT
+  GyroFilter huber, cauchy, plain, reference;
+  std::get<0>(huber.residuals_).loss_ = RobustLoss::kHuber;
+  std::get<0>(cauchy.residuals_).loss_ = RobustLoss::kCauchy;
+  const Vec3 referenceEstimate = RunGyroFilter(reference, 4);
+  const double errorHuber = (RunGyroFilter(huber, 5) - referenceEstimate).norm();
+  const double errorCauchy = (RunGyroFilter(cauchy, 5) - referenceEstimate).norm();
+  const double errorPlain = (RunGyroFilter(plain, 5) - referenceEstimate).norm();
+  EXPECT_LT(errorHuber, 0.1 * errorPlain);
+  EXPECT_LT(errorCauchy, errorHuber);
+}
+
+TEST(Gating, AcceptsCorrectMeasurementUnderLargeUncertainty) {  // NOLINT
+  // The innovation is far outside the measurement noise but well within the state uncertainty
+  UncertainGyroFilter filter;
+  std::get<0>(filter.residuals_).gateTh_ = 16.27;
+  const TimePoint start = Clock::now();
+  const TimePoint t = start + fromSec(0.1);
+  filter.AddMeas<0>(t, std::make_shared<MeasGyr>(Vec3(5, -5, 5)));
+  filter.Init(start);
+  filter.I_ = 1e-4 * MatX::Identity(6, 6);
+  filter.MakeUpdateStep(t);
+  EXPECT_EQ(filter.GetRejectionCounts()[0], 0);
+  EXPECT_GT(std::get<0>(filter.residuals_).nis_, 0);
+  EXPECT_LT(std::get<0>(filter.residuals_).nis_, 1.0);
+  EXPECT_LT((filter.GetState().Get<0>() + filter.GetState().Get<1>() - Vec3(5, -5, 5)).norm(), 0.1);
+}
+
+TEST(Gating, CurrentResidualUsesSchurComplementCovariance) {  // NOLINT
+  // Prior information a on the previous state and random walks of variance dt, i.e. P = (1/a + dt) * I for rate and
+  // bias. The whitened gyroscope Jacobian is sqrt(dt) * [I I].
+  UncertainGyroFilter filter;
+  std::get<0>(filter.residuals_).gateTh_ = 16.27;
+  const double a = 0.5;
+  const double dt = 0.1;
+  const Vec3 gyr(1, -1, 1);
+  const TimePoint start = Clock::now();
+  const TimePoint t = start + fromSec(dt);
+  filter.AddMeas<0>(t, std::make_shared<MeasGyr>(gyr));
+  filter.Init(start);
+  filter.I_ = a * MatX::Identity(6, 6);
+  filter.MakeUpdateStep(t);
+  const double p = 1 / a + dt;
+  EXPECT_NEAR(std::get<0>(filter.residuals_).nis_, dt * gyr.squaredNorm() / (1 + 2 * p * dt), 1e-6);
+}
+
+TEST(Gating, AcceptedUpdateMatchesUngatedUpdate) {  // NOLINT
+  GyroFilter gated, plain;
+  std::get<0>(gated.residuals_).gateTh_ = 1e9;
+  RunGyroFilter(gated, 6);
+  RunGyroFilter(plain, 6);
+  EXPECT_EQ(gated.GetRejectionCounts()[0], 0);
+  EXPECT_EQ(gated.GetState().Get<0>(), plain.GetState().Get<0>());
+  EXPECT_EQ(gated.GetState().Get<1>(), plain.GetState().Get<1>());
+  EXPECT_TRUE(gated.GetInformation() == plain.GetInformation());
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+
+#include "tsif/filter.h"
+#include "tsif/hypotheses.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>,
+               PositionUpdate<0, POS, ATT, -1, -2, -3>, AttitudeUpdate<0, ATT, -2, -4>>
+    PoseFilter;
+
+// Stationary vehicle at the origin with a position measurement pos
+void AddStationary(PoseFilter& filter, TimePoint t, const Vec3& pos) {
+  filter.AddMeas<2>(t, std::make_shared<MeasAcc>(Vec3(0, 0, 9.81)));
+  filter.AddMeas<3>(t, std::make_shared<MeasGyr>(Vec3::Zero()));
+  filter.AddMeas<6>(t, std::make_shared<MeasPos>(pos));
+  filter.AddMeas<7>(t, std::make_shared<MeasAtt>(Quat::Identity()));
+}
+
+// Exposes the staging worker of the pipelined update
+class PipelinedPoseFilter : public PoseFilter {
+ public:
+  using PoseFilter::stagingWorker_;
+};
+
+}  // namespace
+
+TEST(Hypotheses, ClonesShareTimelinesCopyOnWrite) {  // NOLINT
+  PoseFilter base;
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 10; i++) {
+    AddStationary(base, start + fromSec(0.01 * i), Vec3::Zero());
+    base.Update();
+  }
+  EXPECT_FALSE(base.HasPendingUpdate());
+  PoseFilter clone(base);
+  AddStationary(clone, start + fromSec(0.1), Vec3::Zero());
+  EXPECT_TRUE(clone.HasPendingUpdate());
+  EXPECT_FALSE(base.HasPendingUpdate());
+  clone.Update();
+  EXPECT_EQ(clone.GetTime(), start + fromSec(0.1));
+  EXPECT_EQ(base.GetTime(), start + fromSec(0.09));
+}
+
+TEST(Hypotheses, CommitsMostLikelyAssociation) {  // NOLINT
+  PoseFilter base;
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 30; i++) {
+    AddStationary(base, start + fromSec(0.01 * i), Vec3::Zero());
+    base.Update();
+  }
+  const TimePoint t = start + fromSec(0.3);
+  std::vector<Vec3> candidates = {Vec3(2, 0, 0), Vec3(0.01, 0, 0), Vec3(0, -3, 1)};
+  std::vector<std::function<void(PoseFilter&)>> hypotheses;
+  for (const Vec3& pos : candidates) {
+    hypotheses.push_back([t, pos](PoseFilter& filter) {
+      AddStationary(filter, t, pos);
+      filter.Update();
+    });
+  }
+  PoseFilter expected(base);
+  expected.SetInnovationScoring(true);
+  hypotheses[1](expected);
+
+  ThreadPool pool(3);
+  std::vector<double> scores;
+  EXPECT_EQ(EvaluateHypotheses(base, hypotheses, pool, &scores), 1);
+  ASSERT_EQ(scores.size(), 3u);
+  EXPECT_GT(scores[1], scores[0]);
+  EXPECT_GT(scores[1], scores[2]);
+  EXPECT_EQ(base.GetTime(), t);
+  EXPECT_EQ(base.GetState().Get<POS>(), expected.GetState().Get<POS>());
+  EXPECT_TRUE(base.GetInformation() == expected.GetInformation());
+  EXPECT_EQ(base.GetAccumulatedCost(), expected.GetAccumulatedCost());
+
+  // The committed filter continues with the timelines of the winner
+  AddStationary(base, t + fromSec(0.01), Vec3::Zero());
+  AddStationary(expected, t + fromSec(0.01), Vec3::Zero());
+  base.Update();
+  expected.Update();
+  EXPECT_EQ(base.GetState().Get<POS>(), expected.GetState().Get<POS>());
+}
+
+TEST(Hypotheses, GatedWrongAssociationLoses) {  // NOLINT
+  PoseFilter base;
+  std::get<6>(base.residuals_).gateTh_ = 11.34;  // 99% quantile for 3 degrees of freedom
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 30; i++) {
+    AddStationary(base, start + fromSec(0.01 * i), Vec3::Zero());
+    base.Update();
+  }
+  const TimePoint t = start + fromSec(0.3);
+  std::vector<std::function<void(PoseFilter&)>> hypotheses;
+  std::vector<int> rejectionCounts(2);
+  for (const Vec3& pos : {Vec3(5, 0, 0), Vec3(0.01, 0, 0)}) {
+    hypotheses.push_back([t, pos, &rejectionCounts](PoseFilter& filter) {
+      AddStationary(filter, t, pos);
+      filter.Update();
+      rejectionCounts[pos.x() < 1] = filter.GetRejectionCounts()[6];
+    });
+  }
+
+  // The wrong association is rejected by the gating, but pays for it
+  ThreadPool pool(2);
+  std::vector<double> scores;
+  EXPECT_EQ(EvaluateHypotheses(base, hypotheses, pool, &scores), 1);
+  ASSERT_EQ(scores.size(), 2u);
+  EXPECT_GT(scores[1], scores[0]);
+  EXPECT_EQ(rejectionCounts[0], 1);
+  EXPECT_EQ(rejectionCounts[1], 0);
+  EXPECT_NEAR(base.GetState().Get<POS>().x(), 0.0, 0.01);
+}
+
+TEST(Hypotheses, PipelinedClonesStageOnTheirOwnWorker) {  // NOLINT
+  PipelinedPoseFilter base;
+  PoseFilter reference;
+  base.SetPipelining(true);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 10; i++) {
+    AddStationary(base, start + fromSec(0.01 * i), Vec3::Zero());
+    AddStationary(reference, start + fromSec(0.01 * i), Vec3::Zero());
+  }
+  base.Update();
+  reference.Update();
+  ASSERT_NE(base.stagingWorker_, nullptr);
+
+  // Clones updated in parallel stage their steps on their own workers
+  std::vector<std::function<void(PipelinedPoseFilter&)>> hypotheses;
+  for (const Vec3& pos : {Vec3(0.5, 0, 0), Vec3(0.01, 0, 0)}) {
+    hypotheses.push_back([start, pos, &base](PipelinedPoseFilter& filter) {
+      EXPECT_EQ(filter.stagingWorker_, nullptr);
+      for (int i = 10; i < 15; i++) {
+        AddStationary(filter, start + fromSec(0.01 * i), pos);
+      }
+      filter.Update();
+      EXPECT_NE(filter.stagingWorker_, nullptr);
+      EXPECT_NE(filter.stagingWorker_, base.stagingWorker_);
+    });
+  }
+  for (int i = 10; i < 15; i++) {
+    AddStationary(reference, start + fromSec(0.01 * i), Vec3(0.01, 0, 0));
+  }
+  reference.Update();
+  ThreadPool pool(2);
+  EXPECT_EQ(EvaluateHypotheses(base, hypotheses, pool), 1);
+  EXPECT_EQ(base.GetTime(), reference.GetTime());
+  EXPECT_EQ(base.GetState().Get<POS>(), reference.GetState().Get<POS>());
+  EXPECT_TRUE(base.GetInformation() == reference.GetInformation());
+}
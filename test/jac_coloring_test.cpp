@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include "tsif/residuals/bearing_findif.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef BearingFindif<0, 0, 1, 2, 3, 4, 5, 4> Bearing;
+
+}  // namespace
+
+TEST(JacColoring, GreedyColoringSeparatesSharedRows) {  // NOLINT
+  Eigen::Matrix<bool, -1, -1> pattern(3, 4);
+  pattern << true, false, true, false,
+             false, true, false, false,
+             false, false, true, true;
+  JacColoring coloring(pattern);
+  ASSERT_EQ(coloring.GetGroupCount(), 2);
+  EXPECT_EQ(coloring.groups_[0], std::vector<int>({0, 1, 3}));
+  EXPECT_EQ(coloring.groups_[1], std::vector<int>({2}));
+}
+
+TEST(JacColoring, ColoredFindifMatchesFullFindif) {  // NOLINT
+  Bearing res;
+  res.dt_ = 0.1;
+  Bearing::Previous pre;
+  Bearing::Current cur;
+  pre.SetRandom();
+  cur.SetRandom();
+  const std::tuple<Bearing::Previous::CRef, Bearing::Current::CRef> ins(pre, cur);
+  JacColoring coloring;
+  res.JacSparsity<0>(1e-6, 1e-10, coloring, ins);
+  // 2 bearing columns and 1 distance column shared by all landmarks, 12 columns of vel, ror, vep and vea
+  EXPECT_EQ(coloring.GetGroupCount(), 15);
+
+  MatX J_FD = MatX::Zero(Bearing::Output::Dim(), Bearing::Previous::Dim());
+  MatX J_CFD = MatX::Zero(Bearing::Output::Dim(), Bearing::Previous::Dim());
+  MatX J = MatX::Zero(Bearing::Output::Dim(), Bearing::Previous::Dim());
+  res.JacFindifFull<0>(1e-6, J_FD, ins);
+  res.JacFindifColored<0>(1e-6, J_CFD, coloring, ins);
+  EXPECT_LT((J_FD - J_CFD).array().abs().maxCoeff(), 1e-8);
+  res.JacFindifColored<0>(1e-5, J_CFD, coloring, ins, true);
+  res.JacPre(J, pre, cur);
+  EXPECT_LT((J - J_CFD).array().abs().maxCoeff(), 1e-8);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/bearing_findif.h"
+#include "tsif/residuals/distance_findif.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/pose_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+constexpr int kSamples = 500;
+constexpr double kDelta = 1e-6;
+constexpr double kThreshold = 1e-6;
+
+std::string ToString(double x) {
+  std::ostringstream out;
+  out << std::scientific << x;
+  return out.str();
+}
+
+struct JacStatistics {
+  double max = 0;
+  double mean = 0;
+  int failures = 0;
+};
+
+// Checks JacPre/JacCur against central differences at random states, on all cores with a copy of the residual per
+// thread. Every sample draws its states from its own random stream, such that they do not depend on the thread count.
+template <typename Res, int N>
+JacStatistics CheckJacobian(const Res& res) {
+  std::vector<double> errors(kSamples);
+  const int threadCount = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++) {
+    threads.emplace_back([&, t]() {
+      Res resCopy(res);
+      typename Res::Previous pre;
+      typename Res::Current cur;
+      for (int i = t; i < kSamples; i += threadCount) {
+        NormalRandomNumberGenerator::Instance().SetStream(N, i);
+        pre.SetRandom();
+        cur.SetRandom();
+        const std::tuple<typename Res::Previous::CRef, typename Res::Current::CRef> ins(pre, cur);
+        errors[i] = resCopy.template JacError<N>(kDelta, ins, true);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  JacStatistics statistics;
+  for (double e : errors) {
+    statistics.max = std::max(statistics.max, e);
+    statistics.mean += e / kSamples;
+    statistics.failures += !(e <= kThreshold);
+  }
+  return statistics;
+}
+
+template <typename Res>
+class Jacobian : public ::testing::Test {};
+
+typedef ::testing::Types<PositionFindif<0, 0, 1, 2>,
+                         AttitudeFindif<0, 0, 1>,
+                         AccelerometerPrediction<0, 0, 1, 2, 3>,
+                         GyroscopeUpdate<0, 0, 1>,
+                         RandomWalk<Element<Vec3, 0>, Element<Quat, 1>, Element<UnitVector, 2>>,
+                         BearingFindif<0, 0, 1, 2, 3, 4, 5, 4>,
+                         DistanceFindif<0, 0, 1, 2, 3, 4, 5, 4>,
+                         PositionUpdate<0, 0, 1, 2, 3, 4>,
+                         AttitudeUpdate<0, 0, 1, 2>,
+                         PoseUpdate<0, 1, 0, 1, 2, 3, 4, 5>>
+    Residuals;
+TYPED_TEST_SUITE(Jacobian, Residuals);
+
+}  // namespace
+
+// Error statistics end up in the report of --gtest_output=xml or json
+TYPED_TEST(Jacobian, MatchesFiniteDifferences) {  // NOLINT
+  TypeParam res;
+  res.dt_ = 0.1;
+  const JacStatistics pre = CheckJacobian<TypeParam, 0>(res);
+  const JacStatistics cur = CheckJacobian<TypeParam, 1>(res);
+  this->RecordProperty("samples", kSamples);
+  this->RecordProperty("pre_max_error", ToString(pre.max));
+  this->RecordProperty("pre_mean_error", ToString(pre.mean));
+  this->RecordProperty("cur_max_error", ToString(cur.max));
+  this->RecordProperty("cur_mean_error", ToString(cur.mean));
+  EXPECT_EQ(pre.failures, 0) << "max error " << pre.max;
+  EXPECT_EQ(cur.failures, 0) << "max error " << cur.max;
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "tsif/linearization_cache.h"
+#include "tsif/residuals/bearing_findif.h"
+#include "tsif/residuals/distance_findif.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef BearingFindif<0, 0, 1, 2, 3, 4, 5, 3> Bearing;
+typedef DistanceFindif<0, 0, 1, 2, 3, 4, 5, 3> Distance;
+
+}  // namespace
+
+TEST(LinearizationCache, ComputesLazilyOncePerStep) {  // NOLINT
+  LinearizationCache<> cache;
+  const auto key = LinearizationCache<>::MakeKey(0, CachedQuantity::kCameraVelocity, 1, 2);
+  int count = 0;
+  auto compute = [&count]() {
+    count++;
+    return Vec3(count, 0, 0);
+  };
+  const Vec3& value = cache.Get<Vec3>(key, compute);
+  cache.Get<Vec3>(key, compute);
+  EXPECT_EQ(count, 1);
+  for (int id = 0; id < 100; id++) {
+    cache.GetRotationMatrix(1, id, Quat::Identity());
+  }
+  EXPECT_EQ(value(0), 1.0);
+  cache.Invalidate();
+  cache.Get<Vec3>(key, compute);
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(value(0), 2.0);
+}
+
+TEST(LinearizationCache, SharedBetweenResiduals) {  // NOLINT
+  Bearing bearing;
+  Distance distance;
+  Bearing::Previous pre;
+  Bearing::Current bearingCur;
+  Distance::Current distanceCur;
+  pre.SetRandom();
+  bearingCur.SetRandom();
+  distanceCur.SetRandom();
+  Bearing::Output bearingRef, bearingOut;
+  Distance::Output distanceRef, distanceOut;
+  bearing.EvalRes(bearingRef, pre, bearingCur);
+  distance.EvalRes(distanceRef, pre, distanceCur);
+
+  LinearizationCache<> cache;
+  bearing.cache_ = &cache;
+  distance.cache_ = &cache;
+  bearing.EvalRes(bearingOut, pre, bearingCur);
+  distance.EvalRes(distanceOut, pre, distanceCur);
+  Vec<6> dif;
+  bearingOut.Boxminus(bearingRef, dif);
+  EXPECT_LT(dif.norm(), 1e-12);
+  distanceOut.Boxminus(distanceRef, dif.head<3>());
+  EXPECT_LT(dif.head<3>().norm(), 1e-12);
+
+  // The camera velocity has been computed by the bearing residual and re-used by the distance residual
+  const Mat3 C_VI = pre.Get<5>().toRotationMatrix();
+  const Vec3 vel = C_VI * (pre.Get<2>() + pre.Get<3>().cross(pre.Get<4>()));
+  const Vec3& cached = cache.Get<Vec3>(LinearizationCache<>::MakeKey(0, CachedQuantity::kCameraVelocity, 2, 3, 4, 5), []() {
+    ADD_FAILURE() << "Camera velocity not cached";
+    return Vec3(Vec3::Zero());
+  });
+  EXPECT_LT((cached - vel).norm(), 1e-12);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef Filter<RandomWalk<Element<Vec3, 0>, Element<BoundedArray<Vec3, 4>, 1>>> LandmarkFilterBase;
+
+// Exposes the information matrix for setting up coupled problems
+class LandmarkFilter : public LandmarkFilterBase {
+ public:
+  using LandmarkFilterBase::I_;
+};
+
+// Random information where slot 0 is coupled to the pose and slot 1, and slots 2/3 are decoupled
+MatX RandomInformation() {
+  MatX A = MatX::Zero(15, 15);
+  for (int i = 0; i < 15; i++) {
+    A.col(i) = NormalRandomNumberGenerator::Instance().GetVec<15>();
+  }
+  MatX I = A * A.transpose() + MatX::Identity(15, 15);
+  I.block(9, 0, 6, 9).setZero();
+  I.block(0, 9, 9, 6).setZero();
+  I.block(9, 9, 6, 6) = MatX::Identity(6, 6);
+  return I;
+}
+
+}  // namespace
+
+TEST(Marginalization, SchurComplementKeepsMarginalCovariance) {  // NOLINT
+  LandmarkFilter filter;
+  filter.I_ = RandomInformation();
+  const MatX covBefore = filter.GetCovariance();
+  filter.MarginalizeSlot<1>(0);
+  const MatX covAfter = filter.GetCovariance();
+  const std::vector<int> rest({0, 1, 2, 6, 7, 8, 9, 10, 11, 12, 13, 14});
+  EXPECT_LT((MatX(covAfter(rest, rest)) - MatX(covBefore(rest, rest))).norm(), 1e-10);
+  EXPECT_LT((filter.GetInformation().block(3, 3, 3, 3) - MatX::Identity(3, 3)).norm(), 1e-12);
+  EXPECT_EQ(filter.GetInformation().block(3, 0, 3, 3).norm(), 0);
+  EXPECT_EQ(filter.GetInformation().block(3, 6, 3, 9).norm(), 0);
+  EXPECT_FALSE(filter.GetState().Get<1>().IsActive(0));
+}
+
+TEST(Marginalization, ResetSlotInsertsPrior) {  // NOLINT
+  LandmarkFilter filter;
+  filter.I_ = RandomInformation();
+  const MatX I = filter.GetInformation();
+  const Vec3 value(1, 2, 3);
+  filter.ResetSlot<1>(2, value, 4 * MatX::Identity(3, 3));
+  // Slot 2 was decoupled, so the rest of the information is untouched
+  const std::vector<int> rest({0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 13, 14});
+  EXPECT_EQ(MatX(filter.GetInformation()(rest, rest)), MatX(I(rest, rest)));
+  EXPECT_EQ(filter.GetInformation().block(9, 9, 3, 3), 4 * MatX::Identity(3, 3));
+  EXPECT_TRUE(filter.GetState().Get<1>().IsActive(2));
+  EXPECT_EQ(filter.GetState().Get<1>()[2], value);
+}
+
+TEST(Marginalization, DeactivatedCoupledSlotIsDecoupledConsistently) {  // NOLINT
+  // Slot 0 is correlated with the pose and slot 1 but deactivated without MarginalizeSlot
+  LandmarkFilter direct, marginalized;
+  const TimePoint start = Clock::now();
+  direct.Init(start);
+  marginalized.Init(start);
+  direct.I_ = RandomInformation();
+  marginalized.I_ = direct.I_;
+  const MatX covBefore = direct.GetCovariance();
+  direct.GetState().Get<1>().SetActive(1, true);
+  marginalized.GetState().Get<1>().SetActive(1, true);
+  marginalized.MarginalizeSlot<1>(0);
+  direct.MakeUpdateStep(start + fromSec(0.1));
+  marginalized.MakeUpdateStep(start + fromSec(0.1));
+  const std::vector<int> active({0, 1, 2, 6, 7, 8});
+  const std::vector<int> slot({3, 4, 5});
+  const MatX I = direct.GetInformation();
+  EXPECT_LT((MatX(I(active, active)) - MatX(marginalized.GetInformation()(active, active))).norm(), 1e-10);
+  EXPECT_LT((MatX(I(slot, slot)) - MatX(covBefore(slot, slot)).inverse()).norm(), 1e-10);
+  EXPECT_EQ(MatX(I(slot, active)).norm(), 0);
+  EXPECT_EQ(MatX(I(active, slot)).norm(), 0);
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include "tsif/residuals/pose_update.h"
+#include "tsif/residuals/position_update.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef PositionUpdate<0, 0, 1, 2, 3, 4> Position;
+typedef PoseUpdate<0, 1, 0, 1, 2, 3, 4, 5> Pose;
+
+template <int N>
+Mat<N> RandomCovariance() {
+  Mat<N> A;
+  for (int i = 0; i < N; i++) {
+    A.col(i) = NormalRandomNumberGenerator::Instance().GetVec<N>();
+  }
+  return A * A.transpose() + Mat<N>::Identity();
+}
+
+}  // namespace
+
+TEST(NoiseModel, WhiteningIsUpperTriangularSqrtInformation) {  // NOLINT
+  const Mat<6> R = RandomCovariance<6>();
+  const Mat<6> W = Pose::ComputeWhitening(R);
+  EXPECT_LT((W.triangularView<Eigen::StrictlyLower>().toDenseMatrix()).norm(), 1e-12);
+  EXPECT_LT((W.transpose() * W * R - Mat<6>::Identity()).norm(), 1e-9);
+}
+
+TEST(NoiseModel, WhiteningMatchesDenseProduct) {  // NOLINT
+  Position res;
+  const Mat3 R = RandomCovariance<3>();
+  res.SetNoiseCovariance(R);
+  res.w_ = 2.0;
+  Position::Current cur;
+  cur.SetRandom();
+  Position::Output out;
+  MatX J_pre = MatX::Zero(3, 0);
+  MatX J_cur = MatX::Zero(3, Position::Current::Dim());
+  res.EvalRes(out, Position::Previous(), cur);
+  res.JacCur(J_cur, Position::Previous(), cur);
+  Vec3 y;
+  out.GetVec(y);
+  const MatX J_dense = 2.0 * Position::ComputeWhitening(R) * J_cur;
+  const Vec3 y_dense = 2.0 * Position::ComputeWhitening(R) * y;
+  res.AddNoise(out, J_pre, J_cur, Position::Previous(), cur);
+  out.GetVec(y);
+  EXPECT_LT((y - y_dense).norm(), 1e-10);
+  EXPECT_LT((J_cur - J_dense).norm(), 1e-10);
+}
+
+TEST(NoiseModel, MeasurementCovarianceIsCachedPerMeasurement) {  // NOLINT
+  Pose res;
+  const Mat<6> R1 = RandomCovariance<6>();
+  const Mat<6> R2 = RandomCovariance<6>();
+  res.meas_ = std::make_shared<MeasPose>(Vec3(1, 2, 3), Quat(1, 0, 0, 0), R1);
+  const Pose::NoiseMat* W = res.GetWhitening();
+  ASSERT_NE(W, nullptr);
+  EXPECT_LT((*W - Pose::ComputeWhitening(R1)).norm(), 1e-12);
+  res.meas_ = std::make_shared<MeasPose>(Vec3(1, 2, 3), Quat(1, 0, 0, 0), R2);
+  EXPECT_LT((*res.GetWhitening() - Pose::ComputeWhitening(R2)).norm(), 1e-12);
+  res.meas_ = std::make_shared<MeasPose>(Vec3(1, 2, 3), Quat(1, 0, 0, 0));
+  EXPECT_EQ(res.GetWhitening(), nullptr);
+}
+
+TEST(NoiseModel, PoseUpdateUsesPoseMeasurement) {  // NOLINT
+  Pose res;
+  Pose::Current cur;
+  cur.SetIdentity();
+  res.meas_ = std::make_shared<MeasPose>(Vec3(1, 2, 3), Quat(1, 0, 0, 0));
+  Pose::Output out;
+  res.EvalRes(out, Pose::Previous(), cur);
+  EXPECT_LT((out.Get<0>() + Vec3(1, 2, 3)).norm(), 1e-12);
+  EXPECT_LT(out.Get<1>().norm(), 1e-12);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/random_walk.h"
+#include "tsif/utils/parallel_dense.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef Filter<GyroscopeUpdate<0, 0, 1>, RandomWalk<Element<Vec3, 0>>, RandomWalk<Element<Vec3, 1>>,
+               RandomWalk<Element<Vec<100>, 2>>>
+    LargeFilter;
+
+MatX RandomSpd(int n) {
+  const MatX A = MatX::Random(n, n);
+  return A * A.transpose() + n * MatX::Identity(n, n);
+}
+
+}  // namespace
+
+TEST(ParallelDense, KernelsMatchEigen) {  // NOLINT
+  ThreadPool pool(3);
+  const int n = 150;
+  const MatX A = RandomSpd(n);
+  MatX L = A;
+  ASSERT_TRUE(ParallelLLT(pool, L, 32));
+  EXPECT_LT((L - A.llt().matrixL().toDenseMatrix()).norm(), 1e-9 * A.norm());
+
+  MatX B = MatX::Random(n, 70);
+  const MatX B0 = B;
+  ParallelLowerSolve(pool, L, B, 32);
+  EXPECT_LT((L * B - B0).norm(), 1e-9 * B0.norm());
+
+  const MatX Y = MatX::Random(70, n);
+  MatX C = A;
+  ParallelSubtractGram(pool, Y, C, 32);
+  EXPECT_LT((C - (A - Y.transpose() * Y)).norm(), 1e-9 * A.norm());
+  EXPECT_TRUE(C == C.transpose());
+
+  MatX indefinite = A;
+  indefinite(100, 100) = -1e6;
+  EXPECT_FALSE(ParallelLLT(pool, indefinite, 32));
+}
+
+TEST(ParallelDense, FilterUpdateMatchesSerial) {  // NOLINT
+  LargeFilter serial, parallel;
+  parallel.SetThreadPool(std::make_shared<ThreadPool>(3));
+  parallel.SetParallelDenseThreshold(0);
+  const TimePoint start = Clock::now();
+  for (int i = 1; i <= 10; i++) {
+    const TimePoint t = start + fromSec(0.1 * i);
+    const auto gyr = std::make_shared<MeasGyr>(Vec3(0.1 * i, 0.2, -0.3));
+    for (LargeFilter* filter : {&serial, &parallel}) {
+      filter->AddMeas<0>(t, gyr);
+      if (i == 1) {
+        filter->Init(start);
+      }
+      filter->MakeUpdateStep(t);
+    }
+  }
+  EXPECT_LT((parallel.GetInformation() - serial.GetInformation()).norm(), 1e-9 * serial.GetInformation().norm());
+  EXPECT_LT((parallel.GetState().Get<0>() - serial.GetState().Get<0>()).norm(), 1e-9);
+  EXPECT_LT((parallel.GetState().Get<1>() - serial.GetState().Get<1>()).norm(), 1e-9);
+  EXPECT_GT(serial.GetState().Get<0>().norm(), 0.1);
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>,
+               PositionUpdate<0, POS, ATT, -1, -2, -3>, AttitudeUpdate<0, ATT, -2, -4>>
+    PoseFilter;
+
+// Feeds the same random measurements to all filters in bursts, such that every Update processes a backlog of steps
+void RunPoseFilters(std::vector<PoseFilter*> filters, int steps, int burst) {
+  std::srand(0);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < steps; i++) {
+    const TimePoint t = start + fromSec(0.01 * i);
+    const auto acc = std::make_shared<MeasAcc>(Vec3(0, 0, 9.81) + 0.1 * Vec3::Random());
+    const auto gyr = std::make_shared<MeasGyr>(Vec3::Random());
+    const auto pos = std::make_shared<MeasPos>(Vec3::Random());
+    const auto att = std::make_shared<MeasAtt>(Exp(Vec3(0.1 * Vec3::Random())));
+    for (auto filter : filters) {
+      filter->AddMeas<2>(t, acc);
+      filter->AddMeas<3>(t, gyr);
+      filter->AddMeas<6>(t, pos);
+      filter->AddMeas<7>(t, att);
+      if (i % burst == burst - 1) {
+        filter->Update();
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(Pipeline, PipelinedUpdateIsBitIdentical) {  // NOLINT
+  PoseFilter serial, pipelined, pooled;
+  pipelined.SetPipelining(true);
+  pooled.SetPipelining(true);
+  pooled.SetThreadPool(std::make_shared<ThreadPool>(3));  // Staging overlaps solves which run their own parallel loops
+  RunPoseFilters({&serial, &pipelined, &pooled}, 200, 20);
+  for (const PoseFilter* filter : {&pipelined, &pooled}) {
+    EXPECT_EQ(filter->GetState().Get<POS>(), serial.GetState().Get<POS>());
+    EXPECT_EQ(filter->GetState().Get<VEL>(), serial.GetState().Get<VEL>());
+    EXPECT_EQ(filter->GetState().Get<ATT>().coeffs(), serial.GetState().Get<ATT>().coeffs());
+    EXPECT_EQ(filter->GetState().Get<ROR>(), serial.GetState().Get<ROR>());
+    EXPECT_TRUE(filter->GetInformation() == serial.GetInformation());
+    EXPECT_EQ(filter->GetPipelineStats().steps_, serial.GetPipelineStats().steps_);
+  }
+}
+
+TEST(Pipeline, OverlappedSplitAndMergeIsBitIdentical) {  // NOLINT
+  // The IMU runs off the update grid of the pose measurements, every step splits and merges its measurements
+  PoseFilter serial, pipelined, pooled;
+  pipelined.SetPipelining(true);
+  pooled.SetPipelining(true);
+  pooled.SetThreadPool(std::make_shared<ThreadPool>(3));
+  std::srand(0);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < 270; i++) {
+    const TimePoint t = start + fromSec(0.0037 * i);
+    const auto acc = std::make_shared<MeasAcc>(Vec3(0, 0, 9.81) + 0.1 * Vec3::Random());
+    const auto gyr = std::make_shared<MeasGyr>(Vec3::Random());
+    for (auto filter : {&serial, &pipelined, &pooled}) {
+      filter->AddMeas<2>(t, acc);
+      filter->AddMeas<3>(t, gyr);
+    }
+  }
+  for (int i = 0; i < 100; i++) {
+    const TimePoint t = start + fromSec(0.01 * i);
+    const auto pos = std::make_shared<MeasPos>(Vec3::Random());
+    const auto att = std::make_shared<MeasAtt>(Exp(Vec3(0.1 * Vec3::Random())));
+    for (auto filter : {&serial, &pipelined, &pooled}) {
+      filter->AddMeas<6>(t, pos);
+      filter->AddMeas<7>(t, att);
+    }
+  }
+  for (auto filter : {&serial, &pipelined, &pooled}) {
+    filter->Update();
+  }
+  EXPECT_GT(serial.GetPipelineStats().steps_, 50);
+  for (const PoseFilter* filter : {&pipelined, &pooled}) {
+    EXPECT_EQ(filter->GetTime(), serial.GetTime());
+    EXPECT_EQ(filter->GetState().Get<POS>(), serial.GetState().Get<POS>());
+    EXPECT_EQ(filter->GetState().Get<ATT>().coeffs(), serial.GetState().Get<ATT>().coeffs());
+    EXPECT_EQ(filter->GetState().Get<ROR>(), serial.GetState().Get<ROR>());
+    EXPECT_TRUE(filter->GetInformation() == serial.GetInformation());
+  }
+}
+
+TEST(Pipeline, ReportsStageOccupancy) {  // NOLINT
+  PoseFilter filter;
+  filter.SetPipelining(true);
+  filter.SetThreadPool(std::make_shared<ThreadPool>(2));
+  RunPoseFilters({&filter}, 100, 10);
+  const PoseFilter::PipelineStats& stats = filter.GetPipelineStats();
+  EXPECT_GT(stats.steps_, 50);
+  EXPECT_GT(stats.GetSolveOccupancy(), 0);
+  EXPECT_LE(stats.GetSolveOccupancy(), 1);
+  EXPECT_GT(stats.GetStageOccupancy(), 0);
+  EXPECT_LE(stats.waitTime_, stats.wallTime_);
+  filter.ResetPipelineStats();
+  EXPECT_EQ(filter.GetPipelineStats().steps_, 0);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>>
+    ImuFilter;
+typedef Filter<GyroscopeUpdate<0, 0, 1>, RandomWalk<Element<Vec3, 0>>, RandomWalk<Element<Vec3, 1>>> GyroFilter;
+
+constexpr double kDt = 0.01;
+
+// Buffers n inertial samples after start and initializes the filter at start (nothing is processed)
+void BufferImu(ImuFilter& filter, TimePoint start, int n, const Vec3& acc, const Vec3& gyr) {
+  for (int i = 0; i <= n; i++) {
+    filter.AddMeas<2>(start + fromSec(kDt * i), std::make_shared<MeasAcc>(acc));
+    filter.AddMeas<3>(start + fromSec(kDt * i), std::make_shared<MeasGyr>(gyr));
+  }
+  filter.SetPredictionResidual<3>(true);
+  filter.Init(start);
+}
+
+}  // namespace
+
+TEST(Prediction, PropagatesBufferedMeasurements) {  // NOLINT
+  ImuFilter filter;
+  const TimePoint start = Clock::now();
+  BufferImu(filter, start, 100, Vec3(1, 0, 9.81), Vec3::Zero());
+  const MatX information = filter.GetInformation();
+  for (int k = 1; k <= 100; k++) {
+    const ImuFilter::State state = filter.PredictState(start + fromSec(kDt * k));
+    EXPECT_NEAR(state.Get<VEL>()(0), kDt * k, 1e-6);
+    EXPECT_NEAR(state.Get<POS>()(0), kDt * kDt * k * (k - 1) / 2, 1e-6);
+    EXPECT_NEAR(state.Get<POS>().tail<2>().norm(), 0, 1e-6);
+  }
+  // The last measurement is held beyond the buffer
+  EXPECT_NEAR(filter.PredictState(start + fromSec(kDt * 100.5)).Get<VEL>()(0), kDt * 100.5, 1e-6);
+
+  // The estimate is not modified
+  EXPECT_EQ(filter.GetState().Get<VEL>(), Vec3::Zero());
+  EXPECT_TRUE(filter.GetInformation() == information);
+}
+
+TEST(Prediction, IntegratesRotationalRate) {  // NOLINT
+  ImuFilter filter;
+  const TimePoint start = Clock::now();
+  BufferImu(filter, start, 50, Vec3(0, 0, 9.81), Vec3(0, 0, 1));
+  const ImuFilter::State state = filter.PredictState(start + fromSec(kDt * 50));
+  // The attitude is integrated with the rate of the previous step
+  EXPECT_NEAR(Boxminus(state.Get<ATT>(), Exp(Vec3(0, 0, kDt * 49))).norm(), 0, 1e-6);
+  EXPECT_NEAR(state.Get<ROR>()(2), 1, 1e-6);
+  EXPECT_NEAR(state.Get<VEL>().norm(), 0, 1e-6);
+}
+
+TEST(Prediction, IncrementalQueriesMatchSingleQuery) {  // NOLINT
+  ImuFilter incremental, single;
+  const TimePoint start = Clock::now();
+  BufferImu(incremental, start, 40, Vec3(0.3, -0.2, 9.5), Vec3(0.1, 0.2, -0.3));
+  BufferImu(single, start, 40, Vec3(0.3, -0.2, 9.5), Vec3(0.1, 0.2, -0.3));
+  for (int k = 1; k <= 80; k++) {
+    incremental.PredictState(start + fromSec(0.5 * kDt * k));
+  }
+  const TimePoint t = start + fromSec(kDt * 40.25);
+  const ImuFilter::State a = incremental.PredictState(t);
+  const ImuFilter::State b = single.PredictState(t);
+  EXPECT_NEAR((a.Get<POS>() - b.Get<POS>()).norm(), 0, 1e-12);
+  EXPECT_NEAR((a.Get<VEL>() - b.Get<VEL>()).norm(), 0, 1e-12);
+  EXPECT_NEAR(Boxminus(a.Get<ATT>(), b.Get<ATT>()).norm(), 0, 1e-12);
+
+  // A late measurement invalidates the cached propagation
+  incremental.AddMeas<2>(start + fromSec(kDt * 10.5), std::make_shared<MeasAcc>(Vec3(0, 0, 9.81)));
+  EXPECT_GT((incremental.PredictState(t).Get<VEL>() - b.Get<VEL>()).norm(), 1e-6);
+}
+
+TEST(Prediction, WhitensWithNoiseModel) {  // NOLINT
+  GyroFilter filter;
+  const TimePoint start = Clock::now();
+  const double dt = 0.05;
+  const Vec3 gyr(1, 1, 1);
+  filter.AddMeas<0>(start + fromSec(dt), std::make_shared<MeasGyr>(gyr));
+  filter.SetPredictionResidual<0>(true);
+  filter.Init(start);
+  const Vec3 R(0.01, 1, 100);
+  std::get<0>(filter.residuals_).SetNoiseCovariance(R.asDiagonal());
+  const GyroFilter::State state = filter.PredictState(start + fromSec(dt));
+  // Per axis, (ror, bias) minimize a * (ror + bias - gyr)^2 + (ror^2 + bias^2) / dt with a = dt / R
+  for (int i = 0; i < 3; i++) {
+    const double a = dt / R(i);
+    const double expected = a * gyr(i) / (2 * a + 1 / dt);
+    EXPECT_NEAR(state.Get<0>()(i), expected, 1e-10);
+    EXPECT_NEAR(state.Get<1>()(i), expected, 1e-10);
+  }
+  // The residual of the filter keeps its own measurement and dt_
+  EXPECT_EQ(std::get<0>(filter.residuals_).dt_, 0.1);
+  EXPECT_NE(std::get<0>(filter.residuals_).meas_->GetGyr(), gyr);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "tsif/utils/random.h"
+#include "tsif/utils/thread_pool.h"
+
+using namespace tsif;
+
+TEST(Random, PhiloxKnownAnswers) {  // NOLINT
+  // Known answer tests of the Random123 reference implementation
+  typedef PhiloxNormalGenerator::Counter Counter;
+  EXPECT_EQ(PhiloxNormalGenerator::Philox({0, 0, 0, 0}, {0, 0}),
+            (Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  EXPECT_EQ(PhiloxNormalGenerator::Philox({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+            (Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+  EXPECT_EQ(PhiloxNormalGenerator::Philox({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+            (Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(Random, BatchedEqualsSequential) {  // NOLINT
+  PhiloxNormalGenerator sequential(42, 3);
+  std::vector<double> expected(203);
+  for (double& x : expected) {
+    x = sequential.Get();
+  }
+  PhiloxNormalGenerator batched(42, 3);
+  std::vector<double> samples;
+  const Vec<3> a = batched.GetVec<3>();
+  samples.insert(samples.end(), a.data(), a.data() + 3);
+  const Vec<97> b = batched.GetVec<97>();
+  samples.insert(samples.end(), b.data(), b.data() + 97);
+  samples.push_back(batched.Get());
+  std::vector<double> c(102);
+  batched.Fill(c.data(), c.size());
+  samples.insert(samples.end(), c.begin(), c.end());
+  EXPECT_EQ(samples, expected);
+
+  // Skipping ahead
+  PhiloxNormalGenerator skipped(42, 3);
+  skipped.SetIndex(150);
+  EXPECT_EQ(skipped.Get(), expected[150]);
+  EXPECT_EQ(skipped.GetIndex(), 151u);
+}
+
+TEST(Random, Moments) {  // NOLINT
+  PhiloxNormalGenerator generator(7);
+  const int n = 200000;
+  std::vector<double> samples(n);
+  generator.Fill(samples.data(), n);
+  double mean = 0;
+  double var = 0;
+  double kurtosis = 0;
+  for (double x : samples) {
+    mean += x / n;
+    var += x * x / n;
+    kurtosis += x * x * x * x / n;
+  }
+  EXPECT_NEAR(mean, 0, 0.01);
+  EXPECT_NEAR(var, 1, 0.015);
+  EXPECT_NEAR(kurtosis, 3, 0.1);
+
+  // Streams are uncorrelated
+  PhiloxNormalGenerator other = generator.Split(1);
+  double cov = 0;
+  for (int i = 0; i < n; i++) {
+    cov += samples[i] * other.Get() / n;
+  }
+  EXPECT_NEAR(cov, 0, 0.01);
+}
+
+TEST(Random, ReproducibleAcrossThreadCounts) {  // NOLINT
+  const int runs = 64;
+  auto draw = [runs](int threads) {
+    ThreadPool pool(threads);
+    std::vector<Vec<8>> result(runs);
+    pool.ParallelFor(runs, [&result](int i) {
+      NormalRandomNumberGenerator::Instance().SetStream(11, i);
+      result[i] = NormalRandomNumberGenerator::Instance().GetVec<8>();
+    });
+    return result;
+  };
+  const std::vector<Vec<8>> serial = draw(1);
+  const std::vector<Vec<8>> parallel = draw(4);
+  for (int i = 0; i < runs; i++) {
+    EXPECT_EQ(serial[i], parallel[i]);
+  }
+  EXPECT_NE(serial[0], serial[1]);
+}
+
+TEST(Random, DefaultStreamDoesNotDependOnThreadOrder) {  // NOLINT
+  NormalRandomNumberGenerator::Instance().SetSeed(5);
+  std::vector<Vec<8>> result(2);
+  auto draw = [&result](int i) { result[i] = NormalRandomNumberGenerator::Instance().GetVec<8>(); };
+  std::thread a(draw, 0);
+  a.join();
+  std::thread b(draw, 1);
+  b.join();
+  // The seed is process-wide and every thread starts at the beginning of the default stream
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(result[i], PhiloxNormalGenerator(5, 0).GetVec<8>());
+  }
+}
+
+TEST(Random, SelectedStreamsLastUntilSetSeed) {  // NOLINT
+  NormalRandomNumberGenerator::Instance().SetSeed(5);
+  std::vector<Vec<8>> result(2);
+  auto draw = [&result](int i) {
+    NormalRandomNumberGenerator::Instance().SetStream(5, i + 1);
+    result[i] = NormalRandomNumberGenerator::Instance().GetVec<8>();
+  };
+  std::thread a(draw, 0);
+  std::thread b(draw, 1);
+  a.join();
+  b.join();
+  EXPECT_NE(result[0], result[1]);
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(result[i], PhiloxNormalGenerator(5, i + 1).GetVec<8>());
+  }
+  NormalRandomNumberGenerator::Instance().SetStream(5, 1);
+  NormalRandomNumberGenerator::Instance().SetSeed(6);
+  EXPECT_EQ(NormalRandomNumberGenerator::Instance().GetVec<8>(), PhiloxNormalGenerator(6, 0).GetVec<8>());
+}
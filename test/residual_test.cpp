@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/random_walk.h"
+
+using namespace tsif;
+
+namespace {
+
+typedef ElementVector<Element<Vec3, 0>> WalkOutput;
+typedef ElementVector<Element<Vec3, 0>> WalkState;
+
+// Random walk through the virtual adapter with a runtime override of the weight
+class VirtualWalk : public Residual<WalkOutput, WalkState, WalkState, MeasEmpty> {
+ public:
+  VirtualWalk() : Residual(true, true, true) {}
+  int EvalRes(WalkOutput::Ref out, const WalkState::CRef pre, const WalkState::CRef cur) override {
+    out.Get<0>() = cur.Get<0>() - pre.Get<0>();
+    return 0;
+  }
+  int JacPre(MatRefX J, const WalkState::CRef /*pre*/, const WalkState::CRef /*cur*/) override {
+    J.block<3, 3>(0, 0) = -Mat3::Identity();
+    return 0;
+  }
+  int JacCur(MatRefX J, const WalkState::CRef /*pre*/, const WalkState::CRef /*cur*/) override {
+    J.block<3, 3>(0, 0) = Mat3::Identity();
+    return 0;
+  }
+  double GetWeight() override { return w_ / sqrt(dt_); }
+};
+
+// Pulls the walk state towards a fixed target, optionally with a previous element it does not depend on
+template <typename Pre>
+class TargetUpdate : public ResidualBase<TargetUpdate<Pre>, WalkOutput, Pre, WalkState, MeasEmpty> {
+ public:
+  typedef ResidualBase<TargetUpdate<Pre>, WalkOutput, Pre, WalkState, MeasEmpty> Base;
+  using typename Base::MatRefX;
+  int EvalRes(WalkOutput::Ref out, const typename Pre::CRef /*pre*/, const WalkState::CRef cur) {
+    out.Get<0>() = cur.Get<0>() - Vec3(1, 2, 3);
+    return 0;
+  }
+  int JacPre(MatRefX /*J*/, const typename Pre::CRef /*pre*/, const WalkState::CRef /*cur*/) { return 0; }
+  int JacCur(MatRefX J, const typename Pre::CRef /*pre*/, const WalkState::CRef cur) {
+    J.template block<3, 3>(0, cur.Start(0)) = Mat3::Identity();
+    return 0;
+  }
+};
+
+}  // namespace
+
+TEST(Residual, ShippedResidualsAreNotPolymorphic) {  // NOLINT
+  EXPECT_FALSE((std::is_polymorphic<PositionFindif<0, 0, 1, 2>>::value));
+  EXPECT_FALSE((std::is_polymorphic<RandomWalk<Element<Vec3, 0>>>::value));
+  EXPECT_TRUE((std::is_polymorphic<VirtualWalk>::value));
+}
+
+TEST(Residual, ConstantJacobianTrait) {  // NOLINT
+  EXPECT_TRUE((ConstantJacobianTrait<RandomWalk<Element<Vec3, 0>, Element<double, 1>>>::value));
+  EXPECT_TRUE((ConstantJacobianTrait<GyroscopeUpdate<0, 0, 1>>::value));
+  EXPECT_FALSE((ConstantJacobianTrait<RandomWalk<Element<Vec3, 0>, Element<Quat, 1>>>::value));
+  EXPECT_FALSE((ConstantJacobianTrait<PositionFindif<0, 0, 1, 2>>::value));
+  EXPECT_FALSE((ConstantJacobianTrait<VirtualWalk>::value));
+}
+
+// The random walk reuses its cached Gram matrix, the virtual walk re-evaluates its Jacobians
+TEST(Residual, VirtualAdapterMatchesStaticDispatch) {  // NOLINT
+  Filter<VirtualWalk> adapted;
+  Filter<RandomWalk<Element<Vec3, 0>>> direct;
+  VirtualWalk walk;
+  EXPECT_EQ(walk.JacPreTest(1e-6, 1e-8), 0);
+  EXPECT_EQ(walk.JacCurTest(1e-6, 1e-8), 0);
+  const TimePoint start = Clock::now();
+  adapted.Init(start);
+  direct.Init(start);
+  for (int i = 1; i <= 5; i++) {
+    adapted.MakeUpdateStep(start + fromSec(0.1 * i));
+    direct.MakeUpdateStep(start + fromSec(0.1 * i));
+  }
+  EXPECT_LT((adapted.GetInformation() - direct.GetInformation()).norm(), 1e-10);
+}
+
+TEST(Residual, CompactJacobiansMatchStateColumns) {  // NOLINT
+  typedef PositionFindif<0, 0, 1, 2> Findif;
+  typedef MergeTrait<ElementVector<Element<Vec3, 5>>, Findif::Previous, Findif::Current>::Type State;
+  Findif res;
+  State pre, cur;
+  pre.SetRandom();
+  cur.SetRandom();
+  MatX J = MatX::Zero(Findif::Output::Dim(), State::Dim());
+  res.JacPre(J, pre, cur);
+  const Findif::Previous::CRef preCompact(pre, CompactLayout());
+  const Findif::Current::CRef curCompact(cur, CompactLayout());
+  EXPECT_EQ(preCompact.Dim(), Findif::Previous::Dim());
+  MatX J_compact = MatX::Zero(Findif::Output::Dim(), Findif::Previous::Dim());
+  res.JacPre(J_compact, preCompact, curCompact);
+  for (int c = 0; c < Findif::Previous::kN; c++) {
+    const int id = Findif::Previous::kIds[c];
+    const int dim = Findif::Previous::kDims[c];
+    EXPECT_EQ(J.middleCols(State::Start(id), dim), J_compact.middleCols(Findif::Previous::Start(id), dim));
+  }
+}
+
+TEST(Residual, CurrentOnlyInformationMatchesStackedProblem) {  // NOLINT
+  Filter<RandomWalk<Element<Vec3, 0>>, TargetUpdate<ElementVector<>>> direct;
+  Filter<RandomWalk<Element<Vec3, 0>>, TargetUpdate<WalkState>> stacked;
+  const TimePoint start = Clock::now();
+  direct.Init(start);
+  stacked.Init(start);
+  for (int i = 1; i <= 5; i++) {
+    direct.MakeUpdateStep(start + fromSec(0.1 * i));
+    stacked.MakeUpdateStep(start + fromSec(0.1 * i));
+  }
+  EXPECT_LT((direct.GetInformation() - stacked.GetInformation()).norm(), 1e-10);
+  EXPECT_LT((direct.GetState().Get<0>() - stacked.GetState().Get<0>()).norm(), 1e-10);
+  EXPECT_LT((direct.GetState().Get<0>() - Vec3(1, 2, 3)).norm(), 0.5);
+}
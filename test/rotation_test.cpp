@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include "tsif/element.h"
+#include "tsif/utils/common.h"
+
+using namespace tsif;
+
+namespace {
+
+// Reference implementations (branching versions the closed-form kernels replaced)
+Quat ExpRef(const Vec3& v) {
+  const double ha = 0.5 * v.norm();
+  const Vec3 im = 0.5 * Sinc(ha) * v;
+  return Quat(cos(ha), im(0), im(1), im(2));
+}
+Vec3 LogRef(const Quat& q) {
+  const double re = q.w();
+  const Vec3 im(q.x(), q.y(), q.z());
+  const double sha = im.norm();
+  return sha < 1e-8 ? ((std::signbit(re) != 0) * -2 + 1) * 2 * im : 2 * atan(sha / re) / sha * im;
+}
+Mat3 RotMatRef(const Vec3& vec) {
+  const double a = vec.norm();
+  if (a < 1e-8) {
+    return Mat3::Identity() + SSM(vec);
+  }
+  const Vec3 axis = vec.normalized();
+  return Mat3::Identity() + sin(a) * SSM(axis) + (1 - cos(a)) * SSM(axis) * SSM(axis);
+}
+Mat3 GammaMatRef(const Vec3& vec) {
+  const double a = vec.norm();
+  if (a < 1e-8) {
+    return Mat3::Identity() + 0.5 * SSM(vec);
+  }
+  const Vec3 axis = vec.normalized();
+  return Mat3::Identity() + (1 - cos(a)) / a * SSM(axis) + (a - sin(a)) / a * SSM(axis) * SSM(axis);
+}
+
+// Random rotation vectors with angles spread over [1e-10, pi] including the series region
+std::vector<Vec3> RandomRotationVectors(int n) {
+  std::vector<Vec3> vs;
+  for (int i = 0; i < n; i++) {
+    const Vec3 axis = NormalRandomNumberGenerator::Instance().GetVec<3>().normalized();
+    const double angle = i % 3 == 0 ? std::pow(10.0, -10.0 + 8.0 * i / n) : M_PI * (i + 0.5) / n;
+    vs.push_back(angle * axis);
+  }
+  return vs;
+}
+
+}  // namespace
+
+TEST(Rotation, ScalarKernelsMatchReference) {  // NOLINT
+  for (const Vec3& v : RandomRotationVectors(1000)) {
+    EXPECT_LT((Exp(v).coeffs() - ExpRef(v).coeffs()).norm(), 1e-12);
+    EXPECT_LT((Log(Exp(v)) - LogRef(ExpRef(v))).norm(), 1e-12);
+    EXPECT_LT((Log(Exp(v)) - v).norm(), 1e-12);
+    EXPECT_LT((RotMat(v) - RotMatRef(v)).norm(), 1e-12);
+    EXPECT_LT((RotMat(v) - Exp(v).toRotationMatrix()).norm(), 1e-12);
+    // The reference loses digits to the cancellation in 1-cos(a) at small angles
+    EXPECT_LT((GammaMat(v) - GammaMatRef(v)).norm(), v.norm() > 1e-3 ? 1e-12 : 1e-8);
+  }
+}
+
+TEST(Rotation, GammaMatInvIsInverse) {  // NOLINT
+  for (const Vec3& v : RandomRotationVectors(1000)) {
+    EXPECT_LT((GammaMatInv(v) - GammaMatRef(v).inverse()).norm(), v.norm() > 1e-3 ? 1e-12 : 1e-8);
+    EXPECT_LT((GammaMatInv(v) * GammaMat(v) - Mat3::Identity()).norm(), 1e-12);
+  }
+}
+
+TEST(Rotation, LogOfNegativeQuaternion) {  // NOLINT
+  for (const Vec3& v : RandomRotationVectors(100)) {
+    Quat q = Exp(v);
+    q.coeffs() *= -1;
+    EXPECT_LT((Log(q) - LogRef(q)).norm(), 1e-12);
+  }
+}
+
+TEST(Rotation, BatchKernelsMatchScalar) {  // NOLINT
+  const std::vector<Vec3> vs = RandomRotationVectors(257);
+  const int n = vs.size();
+  BatchMat<3> v(3, n);
+  for (int i = 0; i < n; i++) {
+    v.col(i) = vs[i];
+  }
+  BatchMat<4> q, qIn(4, n), qOut;
+  BatchMat<3> l;
+  BatchMat<9> R, G, GI;
+  ExpBatch(v, q);
+  LogBatch(q, l);
+  RotMatBatch(v, R);
+  GammaMatBatch(v, G);
+  GammaMatInvBatch(v, GI);
+  for (int i = 0; i < n; i++) {
+    Quat p;
+    ElementTraits<Quat>::SetRandom(p);
+    qIn.col(i) = p.coeffs();
+  }
+  BoxplusBatch(qIn, v, qOut);
+  for (int i = 0; i < n; i++) {
+    EXPECT_LT((Vec<4>(q.col(i)) - Exp(vs[i]).coeffs()).norm(), 1e-14);
+    EXPECT_LT((Vec3(l.col(i)) - Log(Exp(vs[i]))).norm(), 1e-14);
+    EXPECT_LT((Eigen::Map<const Mat3>(Vec<9>(R.col(i)).data()) - RotMat(vs[i])).norm(), 1e-14);
+    EXPECT_LT((Eigen::Map<const Mat3>(Vec<9>(G.col(i)).data()) - GammaMat(vs[i])).norm(), 1e-14);
+    EXPECT_LT((Eigen::Map<const Mat3>(Vec<9>(GI.col(i)).data()) - GammaMatInv(vs[i])).norm(), 1e-14);
+    const Quat p(Vec<4>(qIn.col(i)));
+    EXPECT_LT((Vec<4>(qOut.col(i)) - Boxplus(p, vs[i]).coeffs()).norm(), 1e-14);
+  }
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+#include "tsif/utils/snapshot_buffer.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>,
+               PositionUpdate<0, POS, ATT, -1, -2, -3>, AttitudeUpdate<0, ATT, -2, -4>>
+    PoseFilter;
+
+void RunPoseFilter(PoseFilter& filter, int steps) {
+  std::srand(0);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < steps; i++) {
+    const TimePoint t = start + fromSec(0.01 * i);
+    filter.AddMeas<2>(t, std::make_shared<MeasAcc>(Vec3(0, 0, 9.81) + 0.1 * Vec3::Random()));
+    filter.AddMeas<3>(t, std::make_shared<MeasGyr>(Vec3::Random()));
+    filter.AddMeas<6>(t, std::make_shared<MeasPos>(Vec3::Random()));
+    filter.AddMeas<7>(t, std::make_shared<MeasAtt>(Exp(Vec3(0.1 * Vec3::Random()))));
+    filter.Update();
+  }
+}
+
+}  // namespace
+
+TEST(SnapshotBuffer, ReadersSeeConsistentValues) {  // NOLINT
+  SnapshotBuffer<std::vector<int>> buffer;
+  std::vector<int> value;
+  EXPECT_FALSE(buffer.Read(value));
+
+  std::atomic<bool> done(false);
+  std::atomic<int> inconsistent(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; r++) {
+    readers.emplace_back([&]() {
+      std::vector<int> read;
+      int last = -1;
+      while (!done) {
+        if (buffer.Read(read)) {
+          if (read.size() != 100 || read.front() < last ||
+              std::count(read.begin(), read.end(), read.front()) != 100) {
+            inconsistent++;
+          }
+          last = read.front();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 20000; i++) {
+    buffer.Publish([i](std::vector<int>& slot) { slot.assign(100, i); });
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(inconsistent, 0);
+  ASSERT_TRUE(buffer.Read(value));
+  EXPECT_EQ(value.front(), 19999);
+}
+
+TEST(Snapshot, MatchesFilterAfterUpdate) {  // NOLINT
+  PoseFilter filter;
+  PoseFilter::Snapshot snapshot;
+  EXPECT_FALSE(filter.GetSnapshot(snapshot));
+  const int start = filter.GetState().Start(POS);
+  filter.AddSnapshotCovarianceBlock(start, 3);
+  RunPoseFilter(filter, 50);
+
+  ASSERT_TRUE(filter.GetSnapshot(snapshot));
+  EXPECT_EQ(snapshot.state_.Get<POS>(), filter.GetState().Get<POS>());
+  EXPECT_EQ(snapshot.state_.Get<ATT>().coeffs(), filter.GetState().Get<ATT>().coeffs());
+  const MatX covariance = snapshot.GetCovariance();
+  ASSERT_EQ(covariance.rows(), 3);
+  ASSERT_EQ(covariance.cols(), 3);
+  EXPECT_TRUE(covariance.isApprox(filter.GetCovariance().block(start, start, 3, 3), 1e-9));
+}
+
+TEST(Snapshot, ConcurrentReaderDuringUpdates) {  // NOLINT
+  PoseFilter filter;
+  filter.AddSnapshotCovarianceBlock(filter.GetState().Start(ATT), 3);
+  std::atomic<bool> done(false);
+  int reads = 0;
+  bool monotonic = true;
+  std::thread reader([&]() {
+    PoseFilter::Snapshot snapshot;
+    TimePoint last = TimePoint::min();
+    while (!done || reads == 0) {
+      if (filter.GetSnapshot(snapshot)) {
+        monotonic = monotonic && snapshot.time_ >= last && snapshot.GetCovariance().rows() == 3;
+        last = snapshot.time_;
+        reads++;
+      }
+    }
+  });
+  RunPoseFilter(filter, 100);
+  done = true;
+  reader.join();
+  EXPECT_TRUE(monotonic);
+  EXPECT_GT(reads, 0);
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <future>
+
+#include "tsif/filter.h"
+#include "tsif/residuals/accelerometer_prediction.h"
+#include "tsif/residuals/attitude_findif.h"
+#include "tsif/residuals/attitude_update.h"
+#include "tsif/residuals/gyroscope_update.h"
+#include "tsif/residuals/position_findif.h"
+#include "tsif/residuals/position_update.h"
+#include "tsif/residuals/random_walk.h"
+#include "tsif/utils/thread_pool.h"
+
+using namespace tsif;
+
+namespace {
+
+enum StateEnum { POS, VEL, ATT, ROR, ACB, GYB };
+typedef Filter<PositionFindif<0, POS, VEL, ATT>, AttitudeFindif<0, ATT, ROR>, AccelerometerPrediction<0, VEL, ATT, ROR, ACB>,
+               GyroscopeUpdate<0, ROR, GYB>, RandomWalk<Element<Vec3, ACB>>, RandomWalk<Element<Vec3, GYB>>,
+               PositionUpdate<0, POS, ATT, -1, -2, -3>, AttitudeUpdate<0, ATT, -2, -4>>
+    PoseFilter;
+
+// Feeds the same random inertial and pose measurements to all filters
+void RunPoseFilters(std::vector<PoseFilter*> filters, int steps) {
+  std::srand(0);
+  const TimePoint start = Clock::now();
+  for (int i = 0; i < steps; i++) {
+    const TimePoint t = start + fromSec(0.01 * i);
+    const auto acc = std::make_shared<MeasAcc>(Vec3(0, 0, 9.81) + 0.1 * Vec3::Random());
+    const auto gyr = std::make_shared<MeasGyr>(Vec3::Random());
+    const auto pos = std::make_shared<MeasPos>(Vec3::Random());
+    const auto att = std::make_shared<MeasAtt>(Exp(Vec3(0.1 * Vec3::Random())));
+    for (auto filter : filters) {
+      filter->AddMeas<2>(t, acc);
+      filter->AddMeas<3>(t, gyr);
+      filter->AddMeas<6>(t, pos);
+      filter->AddMeas<7>(t, att);
+      filter->Update();
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ThreadPool, ParallelForVisitsEachIndexOnce) {  // NOLINT
+  ThreadPool pool(4);
+  std::vector<int> visits(1000, 0);
+  for (int run = 0; run < 20; run++) {
+    pool.ParallelFor(static_cast<int>(visits.size()), [&visits](int i) { visits[i]++; });
+  }
+  for (int count : visits) {
+    EXPECT_EQ(count, 20);
+  }
+}
+
+TEST(ThreadPool, NestedParallelForRunsSerially) {  // NOLINT
+  ThreadPool pool(3);
+  std::vector<int> sums(10, 0);
+  pool.ParallelFor(10, [&pool, &sums](int i) { pool.ParallelFor(i + 1, [&sums, i](int j) { sums[i] += j; }); });
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(sums[i], i * (i + 1) / 2);
+  }
+}
+
+TEST(ThreadPool, TasksKnowTheyRunInAPool) {  // NOLINT
+  EXPECT_FALSE(ThreadPool::IsInTask());
+  for (int threads : {1, 3}) {
+    ThreadPool pool(threads);
+    std::vector<int> inTask(10, 0);
+    pool.ParallelFor(10, [&inTask](int i) { inTask[i] = ThreadPool::IsInTask(); });
+    EXPECT_EQ(inTask, std::vector<int>(10, 1));
+    std::promise<bool> submitted;
+    pool.Submit([&submitted]() { submitted.set_value(ThreadPool::IsInTask()); });
+    EXPECT_TRUE(submitted.get_future().get());
+    EXPECT_FALSE(ThreadPool::IsInTask());
+  }
+}
+
+TEST(ThreadPool, ParallelResidualEvaluationIsBitIdentical) {  // NOLINT
+  PoseFilter serial, parallel;
+  parallel.SetThreadPool(std::make_shared<ThreadPool>(4));
+  RunPoseFilters({&serial, &parallel}, 100);
+  EXPECT_EQ(parallel.GetState().Get<POS>(), serial.GetState().Get<POS>());
+  EXPECT_EQ(parallel.GetState().Get<VEL>(), serial.GetState().Get<VEL>());
+  EXPECT_EQ(parallel.GetState().Get<ATT>().coeffs(), serial.GetState().Get<ATT>().coeffs());
+  EXPECT_EQ(parallel.GetState().Get<ROR>(), serial.GetState().Get<ROR>());
+  EXPECT_EQ(parallel.GetState().Get<ACB>(), serial.GetState().Get<ACB>());
+  EXPECT_EQ(parallel.GetState().Get<GYB>(), serial.GetState().Get<GYB>());
+  EXPECT_TRUE(parallel.GetInformation() == serial.GetInformation());
+}